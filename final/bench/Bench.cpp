@@ -0,0 +1,264 @@
+#include "stdafx.h"
+#include "MyClient.h"
+#include "fleepath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+// Micro-benchmarks for the hot functions of the final client.
+//
+// usage: bees_bench [-r repeats] frames...
+//
+// Every file may contain any number of server frames, each terminated by a
+// line holding a single "." (test/*.in, viewer/*.log). Each measurement is
+// run over all loaded frames `repeats` times, and the statistics of the
+// per-repeat wall clock time are written to stdout as JSON.
+
+namespace {
+
+typedef std::vector<std::string> FRAME;
+
+class NULLBUF : public std::streambuf {
+protected:
+	virtual int overflow(int c) { return c; }
+};
+
+class BENCHCLIENT : public MYCLIENT {
+public:
+	using MYCLIENT::Process;
+	using MYCLIENT::GetHeat;
+	using MYCLIENT::GetBestCreepWithQueen;
+	using MYCLIENT::GetOurQueens;
+
+	// as if the frame just arrived
+	void Reset() {
+		mUnitTarget.clear();
+		command_buffer.str(std::string());
+		mTickStart = std::chrono::steady_clock::now();
+	}
+};
+
+struct RESULT {
+	std::string name;
+	int calls; // calls per repeat
+	std::vector<double> samples; // us per repeat
+};
+
+volatile long long sink = 0;
+
+bool LoadFrames(const char* filename, std::vector<FRAME>& frames) {
+	std::ifstream in(filename);
+	if (!in.is_open()) {
+		return false;
+	}
+	FRAME frame;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (!line.empty() && line[line.size() - 1] == '\r') {
+			line.erase(line.size() - 1);
+		}
+		frame.push_back(line);
+		if (line == ".") {
+			frames.push_back(frame);
+			frame.clear();
+		}
+	}
+	if (!frame.empty()) {
+		frames.push_back(frame);
+	}
+	return true;
+}
+
+RESULT Measure(const std::string& name, int repeats,
+		const std::function<int()>& body)
+{
+	RESULT result;
+	result.name = name;
+	result.calls = body(); // warm-up
+	for (int r = 0; r < repeats; ++r) {
+		auto start_t = std::chrono::steady_clock::now();
+		body();
+		auto end_t = std::chrono::steady_clock::now();
+		result.samples.push_back(std::chrono::duration<double, std::micro>(
+				end_t - start_t).count());
+	}
+	return result;
+}
+
+void PrintJson(std::ostream& os, const std::vector<RESULT>& results,
+		int frame_count, int repeats)
+{
+	os << "{\n";
+	os << "  \"frames\": " << frame_count << ",\n";
+	os << "  \"repeats\": " << repeats << ",\n";
+	os << "  \"unit\": \"us\",\n";
+	os << "  \"benchmarks\": [\n";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		auto samples = results[i].samples;
+		std::sort(samples.begin(), samples.end());
+		double n = samples.size();
+		double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+		double var = 0;
+		for (auto s : samples) {
+			var += (s - mean) * (s - mean);
+		}
+		double stddev = n > 1 ? std::sqrt(var / (n - 1)) : 0.0;
+		double median = samples.size() % 2 ?
+				samples[samples.size() / 2] :
+				(samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+		int calls = std::max(1, results[i].calls);
+
+		os << "    {\"name\": \"" << results[i].name << "\""
+			<< ", \"calls\": " << results[i].calls
+			<< ", \"min\": " << samples.front()
+			<< ", \"median\": " << median
+			<< ", \"mean\": " << mean
+			<< ", \"stddev\": " << stddev
+			<< ", \"max\": " << samples.back()
+			<< ", \"median_per_call\": " << median / calls
+			<< "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	os << "  ]\n";
+	os << "}\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+	int repeats = 20;
+	std::vector<FRAME> all_frames;
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "-r" && i + 1 < argc) {
+			repeats = std::max(1, atoi(argv[++i]));
+		} else if (!LoadFrames(argv[i], all_frames)) {
+			std::cerr << "Cannot open " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+
+	// Only ongoing frames with a map, on the same map as the first one are
+	// usable, since the distance cache is built once. Test files also hold
+	// the expected command frames, which are skipped here.
+	std::vector<FRAME> frames;
+	BENCHCLIENT client;
+	for (auto& frame : all_frames) {
+		client.mParser.Parse(frame);
+		if (client.mParser.Arena.empty() ||
+				client.mParser.match_result != PARSER::ONGOING) {
+			continue;
+		}
+		if (frames.empty()) {
+			client.mDistCache.CreateFromParser(client.mParser);
+		} else if (client.mParser.w != client.mDistCache.map_dx ||
+				client.mParser.h != client.mDistCache.map_dy) {
+			continue;
+		}
+		frames.push_back(frame);
+	}
+	if (frames.empty()) {
+		std::cerr << "usage: " << argv[0] << " [-r repeats] frames..." << std::endl;
+		return 1;
+	}
+
+	// Process() and its helpers are chatty, keep stdout for the report
+	NULLBUF null_buf;
+	auto* cout_buf = std::cout.rdbuf(&null_buf);
+
+	std::vector<PARSER> parsed(frames.size());
+	for (std::size_t i = 0; i < frames.size(); ++i) {
+		parsed[i].Parse(frames[i]);
+	}
+
+	std::vector<RESULT> results;
+
+	results.push_back(Measure("PARSER::Parse", repeats, [&]() {
+		PARSER parser;
+		for (auto& frame : frames) {
+			parser.Parse(frame);
+			sink += parser.Units.size();
+		}
+		return int(frames.size());
+	}));
+
+	results.push_back(Measure("DISTCACHE::CreateFromParser", repeats, [&]() {
+		DISTCACHE cache;
+		cache.CreateFromParser(parsed.front());
+		sink += cache.mDistMap.size();
+		return 1;
+	}));
+
+	results.push_back(Measure("DISTCACHE::GetNextTowards", repeats, [&]() {
+		int calls = 0;
+		for (auto& parser : parsed) {
+			std::vector<POS> targets;
+			targets.push_back(parser.OwnHatchery.pos);
+			targets.push_back(parser.EnemyHatchery.pos);
+			for (auto& tumor : parser.CreepTumors) {
+				targets.push_back(tumor.pos);
+			}
+			for (auto& unit : parser.Units) {
+				for (auto& target : targets) {
+					sink += client.mDistCache.GetNextTowards(unit.pos, target).x;
+					++calls;
+				}
+			}
+		}
+		return calls;
+	}));
+
+	results.push_back(Measure("FLEEPATH::CreateCreepDist", repeats, [&]() {
+		for (auto& parser : parsed) {
+			FLEEPATH flee_path;
+			flee_path.CreateCreepDist(&parser);
+			sink += flee_path.GetDistToFriendlyCreep(parser.OwnHatchery.pos);
+		}
+		return int(parsed.size());
+	}));
+
+	results.push_back(Measure("MYCLIENT::GetHeat", repeats, [&]() {
+		int calls = 0;
+		for (auto& parser : parsed) {
+			client.mParser = parser;
+			for (int y = 0; y < client.mParser.h; ++y) {
+				for (int x = 0; x < client.mParser.w; ++x) {
+					POS p(x, y);
+					if (client.mParser.GetAt(p) != PARSER::WALL) {
+						sink += client.GetHeat(p);
+						++calls;
+					}
+				}
+			}
+		}
+		return calls;
+	}));
+
+	results.push_back(Measure("MYCLIENT::GetBestCreepWithQueen", repeats, [&]() {
+		int calls = 0;
+		for (auto& parser : parsed) {
+			client.mParser = parser;
+			client.Reset();
+			for (auto& queen : client.GetOurQueens()) {
+				sink += client.GetBestCreepWithQueen(queen.pos).x;
+				++calls;
+			}
+		}
+		return calls;
+	}));
+
+	results.push_back(Measure("MYCLIENT::Process", repeats, [&]() {
+		for (auto& parser : parsed) {
+			client.mParser = parser;
+			client.Reset();
+			client.Process();
+			sink += client.mUnitTarget.size();
+		}
+		return int(frames.size());
+	}));
+
+	std::cout.rdbuf(cout_buf);
+	PrintJson(std::cout, results, int(frames.size()), repeats);
+	return 0;
+}
@@ -251,12 +251,18 @@ void CLIENT::Run()
 
 std::string CLIENT::HandleServerResponse(std::vector<std::string> &ServerResponse)
 {
+	mTickStart = std::chrono::steady_clock::now();
 	mParser.Parse(ServerResponse);
 	if (mParser.w!=0 && mDistCache.mDistMap.empty())
 	{
 		mDistCache.CreateFromParser(mParser);
 		mDistCache.SaveToFile("distcache.bin");
 	}
+	mWorldState.Update(mParser);
+	for (auto &ev : mWorldState.Died)
+	{
+		mUnitTarget.erase(ev.id);
+	}
 	std::stringstream ss;
 	if (mParser.match_result==PARSER::ONGOING)
 	{
@@ -267,9 +273,7 @@ std::string CLIENT::HandleServerResponse(std::vector<std::string> &ServerRespons
 		{
 			bool cmd_done = false;
 
-			MAP_OBJECT *q = NULL;
-			for(std::vector<MAP_OBJECT>::iterator p=mParser.Units.begin(); p!=mParser.Units.end();p++) { if (p->id==it->first) { q=&*p; break; } }
-			if (q==NULL)
+			if (!mWorldState.IsAlive(it->first))
 			{
 				cmd_done = true;
 			} else if (it->second.c == CLIENT::CMD_MOVE) {
@@ -302,6 +306,7 @@ std::string CLIENT::HandleServerResponse(std::vector<std::string> &ServerRespons
 	} else
 	{
 		mUnitTarget.clear();
+		mWorldState.Reset();
 		MatchEnd();
 		ss<<".";
 	}
@@ -311,45 +316,6 @@ std::string CLIENT::HandleServerResponse(std::vector<std::string> &ServerRespons
 
 
 
-int main(int argc, char* argv[])
-{
-	std::cout.sync_with_stdio(false);
-	std::string server_address;
-	server_address = "172.22.22.173";
-	std::cout<<"using default server address: " + server_address <<std::endl;
-	CLIENT *pClient = CreateClient();
-
-	if (argc > 1) {
-		pClient->opponent = argv[1];
-	}
-
-	/* for debugging:  */
-	std::ifstream debug_file("test.txt");
-	if (debug_file.is_open())
-	{
-		std::string line;
-		std::vector<std::string> full;
-		while (std::getline(debug_file, line))
-		{
-			full.push_back(line);
-		}
-		std::string resp = pClient->DebugResponse(full);
-		std::cout<<"response: "<<resp <<std::endl;
-	}
-	/**/
-
-	pClient->strIPAddress = server_address;
-	if (!pClient->Init())
-	{
-		std::cout<<"Connection failed"<<std::endl;
-	} else
-	{
-		pClient->Run();
-	}
-	delete pClient;
-	return 0;
-}
-
 std::pair<bool, std::string> CLIENT::Move(const std::pair<int, CMD>& cmd) {
 	MAP_OBJECT *q = mParser.FindUnit(cmd.first);
 
@@ -2,6 +2,8 @@
 #include "stdafx.h"
 #include "parser.h"
 #include "distcache.h"
+#include "worldstate.h"
+#include <chrono>
 
 class CLIENT
 {
@@ -18,6 +20,7 @@ public:
 	PARSER mParser;
 	std::stringstream command_buffer;
 	DISTCACHE mDistCache;
+	WORLDSTATE mWorldState;
 	enum eUnitCommand {
 		CMD_MOVE,
 		CMD_ATTACK,
@@ -57,6 +60,7 @@ protected:
 	virtual std::string GetPreferredOpponents() = 0;
 	virtual bool NeedDebugLog() = 0;
 	std::ofstream mDebugLog;
+	std::chrono::steady_clock::time_point mTickStart; // when the frame was handed over
 #ifdef WIN32
 	SOCKET mConnectionSocket;
 #else
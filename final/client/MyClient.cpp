@@ -1,83 +1,14 @@
 #include "stdafx.h"
-#include "Client.h"
-#include "parser.h"
+#include "MyClient.h"
 #include "fleepath.h"
 #include <cmath>
 #include <numeric>
-#include <unordered_set>
 #include <chrono>
 
 #include <boost/range/algorithm_ext/erase.hpp>
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 
-// sample
-//
-
-class MYCLIENT : public CLIENT {
-public:
-	MYCLIENT();
-protected:
-	virtual std::string GetPassword() { return std::string("47JdZX"); }
-	virtual std::string GetPreferredOpponents() { return opponent; }
-	virtual bool NeedDebugLog() { return true; }
-	virtual void Process();
-
-	int last_hatchery_energy_ = 0;
-
-	void PrintStatistics();
-
-	void AttackAttackingQueens();
-	void SpawnOrAttackWithQueens();
-	void SpawnWithTumors();
-	void AttackHatchery();
-
-	void PreprocessUnitTargets();
-	void ReactToHeatMap();
-	int ClosestTumorDistance(const POS& pos, bool enemy = false);
-
-	int GetTumorFitness(const POS& p);
-	int GetEnemyTumorFitness(const POS& pos, int energy);
-	int GetEnemyTumorCrowded(const POS& pos);
-
-	POS GetBestCreepWithQueen(const POS& pos);
-	std::vector<POS> GetCellsInRadius(const POS& pos, int radius = 10);
-	int GetEmptyCountAround(const POS& pos);
-	int GetEnemyCreepCountAround(const POS& pos);
-	bool CanPlaceTumor(const POS& pos);
-	bool HasTentativeTumorAt(const POS& pos);
-	int Distance(const POS& p1, const POS& p2);
-	int RouteDistance(const POS& p1, const POS& p2);
-	int GetAttackTarget(const POS& pos, int force);
-	int GetEnemyThreat(const POS& pos);
-	int GetForce(const POS& pos);
-	int GetHeat(const POS& pos);
-
-	std::vector<MAP_OBJECT> GetOurQueens();
-	std::vector<MAP_OBJECT> GetOurNonFleeingQueens();
-	std::vector<MAP_OBJECT> GetEnemyQueens();
-	std::vector<MAP_OBJECT> GetIntrudingQueens();
-	std::vector<MAP_OBJECT> GetEnemyTumors();
-	std::vector<MAP_OBJECT> GetOurTumors();
-	std::vector<MAP_OBJECT> GetOurActiveTumors();
-
-	bool CanWeDie();
-	bool DoWeHaveMoreCreep();
-	bool AreWeStrongerBy(float ratio = 1.0);
-	static int queenToHealth(const MAP_OBJECT& queen) {
-		return queen.hp;
-	}
-	bool OnOurCreep(const MAP_OBJECT& queen) const {
-		return mParser.GetAt(queen.pos) == PARSER::CREEP;
-	}
-
-	const MAP_OBJECT* GetClosestEnemyNear(const POS& pos);
-
-	std::unordered_set<int> fleeing_queens;
-
-	static constexpr int kHeatThreshold = -40;
-};
-
 MYCLIENT::MYCLIENT() {}
 
 void MYCLIENT::PrintStatistics() {
@@ -148,6 +79,9 @@ void MYCLIENT::SpawnOrAttackWithQueens() {
 	FLEEPATH flee_path;
 	flee_path.CreateCreepDist(&mParser);
 	for (auto& queen : GetOurNonFleeingQueens()) {
+		if (!TimeLeft()) {
+			break;
+		}
 		if (mUnitTarget.count(queen.id)) {
 			// We have a command ready, but let's check if we can interrupt
 			if (queen.energy >= QUEEN_BUILD_CREEP_TUMOR_COST &&
@@ -198,6 +132,9 @@ void MYCLIENT::SpawnWithTumors() {
 					return tumor.energy >= CREEP_TUMOR_SPAWN_ENERGY; });
 
 	for (const auto& tumor : activeTumors) {
+		if (!TimeLeft()) {
+			break;
+		}
 		auto cells = GetCellsInRadius(tumor.pos);
 		auto best = std::max_element(cells.rbegin(), cells.rend(),
 				[this](const POS& l, const POS& r) {
@@ -218,7 +155,10 @@ int MYCLIENT::GetEnemyThreat(const POS& pos) {
 	int sum = 0;
 	int max_dst = 10;
 	for (const auto& queen : GetEnemyQueens()) {
-		auto dst = RouteDistance(queen.pos, pos);
+		auto dst = mEnemyModel.GetProjectedDist(queen.id, pos, kThreatLookahead);
+		if (dst < 0) {
+			dst = RouteDistance(queen.pos, pos);
+		}
 		auto t = mParser.GetAt(queen.pos);
 		float mul = 1.0;
 		if (t == PARSER::ENEMY_CREEP) { mul = 1.25; }
@@ -311,6 +251,9 @@ void MYCLIENT::AttackHatchery() {
 
 void MYCLIENT::ReactToHeatMap() {
 	for (auto& queen : GetOurQueens()) {
+		if (!TimeLeft()) {
+			break;
+		}
 		if (GetHeat(queen.pos) < kHeatThreshold) {
 			if (mParser.GetAt(queen.pos) == PARSER::ENEMY_CREEP) {
 				FLEEPATH flee_path;
@@ -361,26 +304,69 @@ void MYCLIENT::ReactToHeatMap() {
 }
 
 void MYCLIENT::Process() {
+	deadline_ = mTickStart + std::chrono::milliseconds(kTickBudgetMs);
 	fleeing_queens.clear();
-	auto start_t = std::chrono::system_clock::now();
-	PrintStatistics();
+	mEnemyModel.Update(mParser, mWorldState, mDistCache);
 
+	// Refinements from the cheapest to the most expensive one. Each of them
+	// is skipped once the deadline has passed, and the per unit ones stop
+	// between two units.
 	PreprocessUnitTargets();
-	ReactToHeatMap();
-	AttackAttackingQueens();
-	SpawnOrAttackWithQueens();
-	SpawnWithTumors();
-	if (GetOurNonFleeingQueens().size() >= 6) {
+	if (TimeLeft()) {
+		ReactToHeatMap();
+	}
+	if (TimeLeft()) {
+		AttackAttackingQueens();
+	}
+	if (TimeLeft()) {
+		SpawnOrAttackWithQueens();
+	}
+	if (TimeLeft()) {
+		SpawnWithTumors();
+	}
+	if (TimeLeft() && GetOurNonFleeingQueens().size() >= 6) {
 		AttackHatchery();
 	}
 
-	auto end_t = std::chrono::system_clock::now();
+	// Mandatory pass, it runs last so that it never preempts the
+	// refinements above (those skip queens with a pending command).
+	EnsureCommands();
+
+	if (TimeLeft()) {
+		PrintStatistics();
+	}
+
 	auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(
-		end_t - start_t).count();
+		std::chrono::steady_clock::now() - mTickStart).count();
 
 	std::cout << diff << "ms" << std::endl;
 }
 
+void MYCLIENT::EnsureCommands() {
+	for (auto& queen : GetOurQueens()) {
+		if (mUnitTarget.count(queen.id)) {
+			continue;
+		}
+		if (queen.energy >= QUEEN_BUILD_CREEP_TUMOR_COST &&
+				CanPlaceTumor(queen.pos)) {
+			mUnitTarget[queen.id].c = CMD_SPAWN;
+			mUnitTarget[queen.id].pos = queen.pos;
+		} else if (!OnOurCreep(queen)) {
+			// a single step, so that the command is done by the next tick
+			auto next = mDistCache.GetNextTowards(
+					queen.pos, mParser.OwnHatchery.pos);
+			if (next.IsValid()) {
+				mUnitTarget[queen.id].c = CMD_MOVE;
+				mUnitTarget[queen.id].pos = next;
+			}
+		}
+	}
+}
+
+void MYCLIENT::MatchEnd() {
+	mEnemyModel.Reset();
+}
+
 int MYCLIENT::GetTumorFitness(const POS& p) {
 	if (!CanPlaceTumor(p)) {
 		return -1;
@@ -420,6 +406,91 @@ int MYCLIENT::GetEnemyTumorCrowded(const POS& pos) {
 }
 
 POS MYCLIENT::GetBestCreepWithQueen(const POS& pos) {
+	const int w = mParser.w;
+	const int h = mParser.h;
+	const auto& walkable = mDistCache.mMap;
+	if (mDistCache.mDistMap.empty() || mDistCache.map_dx != w ||
+			mDistCache.map_dy != h || !walkable[pos.x + pos.y * w]) {
+		return GetBestCreepWithQueenFullScan(pos);
+	}
+
+	// Every cell we can't place a tumor on scores 10 * -1 - RouteDistance.
+	// RouteDistance is -1 for walls, so the best of those is the first wall.
+	int best_index = std::find(walkable.begin(), walkable.end(), 0) -
+			walkable.begin();
+	if (best_index == int(walkable.size())) {
+		return GetBestCreepWithQueenFullScan(pos);
+	}
+	int best_fit = -9;
+
+	// Summed area tables of empty and enemy creep cells, so that an upper
+	// bound of the fitness can be given for any cell in O(1).
+	const int sw = w + 1;
+	std::vector<int> empty_sum(sw * (h + 1), 0);
+	std::vector<int> enemy_sum(sw * (h + 1), 0);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			auto t = mParser.Arena[x + y * w];
+			int i = (x + 1) + (y + 1) * sw;
+			empty_sum[i] = empty_sum[i - 1] + empty_sum[i - sw] -
+					empty_sum[i - sw - 1] +
+					(t == PARSER::EMPTY || t == PARSER::CREEP_CANDIDATE_ENEMY);
+			enemy_sum[i] = enemy_sum[i - 1] + enemy_sum[i - sw] -
+					enemy_sum[i - sw - 1] + (t == PARSER::ENEMY_CREEP);
+		}
+	}
+	auto box_sum = [sw](const std::vector<int>& sum,
+			int x0, int y0, int x1, int y1) {
+		return sum[x1 + y1 * sw] - sum[x0 + y1 * sw] -
+				sum[x1 + y0 * sw] + sum[x0 + y0 * sw];
+	};
+
+	// GetCellsInRadius(p, 10) lies within the 19x19 box around p, and
+	// ClosestTumorDistance is at most the distance to our hatchery.
+	const int r = 10 - 1;
+	const auto& dist = mDistCache.mDistMap[pos.x + pos.y * w];
+	std::vector<std::pair<int, int>> candidates; // upper bound, index
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			int i = x + y * w;
+			if (mParser.Arena[i] != PARSER::CREEP) {
+				continue;
+			}
+			int x0 = std::max(0, x - r), x1 = std::min(w, x + r + 1);
+			int y0 = std::max(0, y - r), y1 = std::min(h, y + r + 1);
+			int fitness_bound =
+					2 * box_sum(empty_sum, x0, y0, x1, y1) +
+					box_sum(enemy_sum, x0, y0, x1, y1) +
+					Distance(POS(x, y), mParser.OwnHatchery.pos);
+			candidates.push_back({10 * fitness_bound - dist[i], i});
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(),
+			[](const std::pair<int, int>& l, const std::pair<int, int>& r) {
+				return l.first > r.first;
+			});
+
+	// Best-first: stop when no remaining cell can beat the incumbent. Ties
+	// go to the first cell in row-major order, like in the full scan.
+	for (const auto& candidate : candidates) {
+		if (candidate.first < best_fit) {
+			break;
+		}
+		int i = candidate.second;
+		POS p(i % w, i / w);
+		if (!CanPlaceTumor(p)) {
+			continue;
+		}
+		auto fitness = 10 * GetTumorFitness(p) - dist[i];
+		if (fitness > best_fit || (fitness == best_fit && i < best_index)) {
+			best_fit = fitness;
+			best_index = i;
+		}
+	}
+	return POS(best_index % w, best_index / w);
+}
+
+POS MYCLIENT::GetBestCreepWithQueenFullScan(const POS& pos) {
 	POS best_pos = POS(-1, -1);
 	int best_fit = INT_MIN;
 	for (int y = 0; y < mParser.h; ++y) {
@@ -0,0 +1,83 @@
+#pragma once
+#include "stdafx.h"
+#include "Client.h"
+#include "parser.h"
+#include "enemymodel.h"
+#include <unordered_set>
+#include <chrono>
+
+class MYCLIENT : public CLIENT {
+public:
+	MYCLIENT();
+protected:
+	virtual std::string GetPassword() { return std::string("47JdZX"); }
+	virtual std::string GetPreferredOpponents() { return opponent; }
+	virtual bool NeedDebugLog() { return true; }
+	virtual void Process();
+	virtual void MatchEnd();
+
+	int last_hatchery_energy_ = 0;
+
+	void PrintStatistics();
+
+	void AttackAttackingQueens();
+	void SpawnOrAttackWithQueens();
+	void SpawnWithTumors();
+	void AttackHatchery();
+
+	void PreprocessUnitTargets();
+	void EnsureCommands();
+	void ReactToHeatMap();
+	int ClosestTumorDistance(const POS& pos, bool enemy = false);
+
+	int GetTumorFitness(const POS& p);
+	int GetEnemyTumorFitness(const POS& pos, int energy);
+	int GetEnemyTumorCrowded(const POS& pos);
+
+	POS GetBestCreepWithQueen(const POS& pos);
+	POS GetBestCreepWithQueenFullScan(const POS& pos);
+	std::vector<POS> GetCellsInRadius(const POS& pos, int radius = 10);
+	int GetEmptyCountAround(const POS& pos);
+	int GetEnemyCreepCountAround(const POS& pos);
+	bool CanPlaceTumor(const POS& pos);
+	bool HasTentativeTumorAt(const POS& pos);
+	int Distance(const POS& p1, const POS& p2);
+	int RouteDistance(const POS& p1, const POS& p2);
+	int GetAttackTarget(const POS& pos, int force);
+	int GetEnemyThreat(const POS& pos);
+	int GetForce(const POS& pos);
+	int GetHeat(const POS& pos);
+
+	std::vector<MAP_OBJECT> GetOurQueens();
+	std::vector<MAP_OBJECT> GetOurNonFleeingQueens();
+	std::vector<MAP_OBJECT> GetEnemyQueens();
+	std::vector<MAP_OBJECT> GetIntrudingQueens();
+	std::vector<MAP_OBJECT> GetEnemyTumors();
+	std::vector<MAP_OBJECT> GetOurTumors();
+	std::vector<MAP_OBJECT> GetOurActiveTumors();
+
+	bool CanWeDie();
+	bool DoWeHaveMoreCreep();
+	bool AreWeStrongerBy(float ratio = 1.0);
+	static int queenToHealth(const MAP_OBJECT& queen) {
+		return queen.hp;
+	}
+	bool OnOurCreep(const MAP_OBJECT& queen) const {
+		return mParser.GetAt(queen.pos) == PARSER::CREEP;
+	}
+
+	const MAP_OBJECT* GetClosestEnemyNear(const POS& pos);
+
+	std::unordered_set<int> fleeing_queens;
+
+	std::chrono::steady_clock::time_point deadline_;
+	bool TimeLeft() const {
+		return std::chrono::steady_clock::now() < deadline_;
+	}
+	ENEMYMODEL mEnemyModel;
+
+	static constexpr int kHeatThreshold = -40;
+	static constexpr int kThreatLookahead = 2;
+	// The server waits 250ms for the answer, leave some for sending it
+	static constexpr int kTickBudgetMs = 200;
+};
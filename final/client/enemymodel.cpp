@@ -0,0 +1,52 @@
+#include "stdafx.h"
+#include "enemymodel.h"
+
+void ENEMYMODEL::Reset()
+{
+	mTracks.clear();
+}
+
+void ENEMYMODEL::Update(const PARSER &Parser, const WORLDSTATE &World, DISTCACHE &DistCache)
+{
+	for (auto &ev : World.Died)
+	{
+		mTracks.erase(ev.id);
+	}
+	for (auto &u : Parser.Units)
+	{
+		if (!u.IsEnemy()) continue;
+		TRACK &t = mTracks[u.id]; // value initialized for new queens
+		t.head = (t.head + 1) % HISTORY;
+		t.history[t.head] = u.pos;
+		if (t.count < HISTORY) t.count++;
+		t.map_dx = DistCache.map_dx;
+		bool has_row = !DistCache.mDistMap.empty() &&
+			!DistCache.mDistMap[u.pos.x + u.pos.y*DistCache.map_dx].empty();
+		t.dist = has_row ? &DistCache.mDistMap[u.pos.x + u.pos.y*DistCache.map_dx] : NULL;
+		t.moves = 0;
+		for (int i = 1; i < t.count; i++)
+		{
+			int cur = (t.head - i + 1 + HISTORY) % HISTORY;
+			int prev = (t.head - i + HISTORY) % HISTORY;
+			if (t.history[cur] != t.history[prev]) t.moves++;
+		}
+	}
+}
+
+int ENEMYMODEL::GetMobility(int id) const
+{
+	auto it = mTracks.find(id);
+	return it == mTracks.end() ? 0 : it->second.moves;
+}
+
+int ENEMYMODEL::GetProjectedDist(int id, const POS &p, int ahead) const
+{
+	auto it = mTracks.find(id);
+	if (it == mTracks.end() || it->second.dist == NULL) return -1;
+	const TRACK &t = it->second;
+	int d = (*t.dist)[p.x + p.y*t.map_dx];
+	if (d == 0xFF) return -1;
+	// a queen seen only once is assumed to be on the move
+	if (t.count > 1) ahead = ahead * t.moves / (t.count - 1);
+	return std::max(0, d - ahead);
+}
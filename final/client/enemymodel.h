@@ -0,0 +1,38 @@
+#pragma once
+#include "stdafx.h"
+
+#include "parser.h"
+#include "distcache.h"
+#include "worldstate.h"
+
+// Per match model of the enemy queens: the last few positions of every
+// queen, and the distance field of its current cell borrowed from DISTCACHE.
+// The set of cells a queen can reach by t+k is { p : dist(p) <= k }, so
+// projecting it forward needs no pathfinding at all.
+class ENEMYMODEL
+{
+public:
+	static const int HISTORY = 8;
+
+	ENEMYMODEL() {};
+	void Update(const PARSER &Parser, const WORLDSTATE &World, DISTCACHE &DistCache);
+	void Reset();
+
+	// Route distance between p and the closest cell the queen can reach in
+	// `ahead` ticks. Queens that have been standing still are projected less.
+	// Returns -1 for unknown queens and for cells the queen can't reach.
+	int GetProjectedDist(int id, const POS &p, int ahead) const;
+	// Moves made in the last HISTORY ticks, 0..HISTORY-1
+	int GetMobility(int id) const;
+
+private:
+	struct TRACK
+	{
+		POS history[HISTORY]; // ring buffer
+		int head, count;
+		int moves; // in the ring buffer
+		const std::vector<unsigned char> *dist; // DISTCACHE row of the current cell
+		int map_dx;
+	};
+	std::map<int, TRACK> mTracks;
+};
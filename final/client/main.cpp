@@ -0,0 +1,41 @@
+#include "stdafx.h"
+#include "Client.h"
+
+int main(int argc, char* argv[])
+{
+	std::cout.sync_with_stdio(false);
+	std::string server_address;
+	server_address = "172.22.22.173";
+	std::cout<<"using default server address: " + server_address <<std::endl;
+	CLIENT *pClient = CreateClient();
+
+	if (argc > 1) {
+		pClient->opponent = argv[1];
+	}
+
+	/* for debugging:  */
+	std::ifstream debug_file("test.txt");
+	if (debug_file.is_open())
+	{
+		std::string line;
+		std::vector<std::string> full;
+		while (std::getline(debug_file, line))
+		{
+			full.push_back(line);
+		}
+		std::string resp = pClient->DebugResponse(full);
+		std::cout<<"response: "<<resp <<std::endl;
+	}
+	/**/
+
+	pClient->strIPAddress = server_address;
+	if (!pClient->Init())
+	{
+		std::cout<<"Connection failed"<<std::endl;
+	} else
+	{
+		pClient->Run();
+	}
+	delete pClient;
+	return 0;
+}
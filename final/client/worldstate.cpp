@@ -0,0 +1,114 @@
+#include "stdafx.h"
+#include "worldstate.h"
+
+WORLDSTATE::WORLDSTATE()
+{
+	Reset();
+}
+
+void WORLDSTATE::Reset()
+{
+	tick = -1;
+	mGeneration = 0;
+	mObjects.clear();
+	ClearEvents();
+}
+
+void WORLDSTATE::ClearEvents()
+{
+	Spawned.clear();
+	Died.clear();
+	Moved.clear();
+	Damaged.clear();
+	TumorActivated.clear();
+}
+
+static bool IsTumor(UnitType type)
+{
+	return type == UnitType::kCreepTumor || type == UnitType::kEnemyCreepTumor;
+}
+
+void WORLDSTATE::Reconcile(UnitType type, const MAP_OBJECT &ob)
+{
+	if (ob.id < 0) return; // not in the frame
+	auto ins = mObjects.insert(std::make_pair(ob.id, ENTRY()));
+	ENTRY &e = ins.first->second;
+	WORLD_EVENT ev;
+	ev.id = ob.id;
+	ev.type = type;
+	ev.from = ins.second ? ob.pos : e.ob.pos;
+	ev.to = ob.pos;
+	ev.hp_lost = 0;
+	if (ins.second)
+	{
+		Spawned.push_back(ev);
+		if (IsTumor(type) && ob.energy >= CREEP_TUMOR_SPAWN_ENERGY) TumorActivated.push_back(ev);
+	} else
+	{
+		if (e.ob.pos != ob.pos) Moved.push_back(ev);
+		if (IsTumor(type) && e.ob.energy < CREEP_TUMOR_SPAWN_ENERGY &&
+			ob.energy >= CREEP_TUMOR_SPAWN_ENERGY)
+		{
+			TumorActivated.push_back(ev);
+		}
+		if (ob.hp < e.ob.hp)
+		{
+			ev.hp_lost = e.ob.hp - ob.hp;
+			Damaged.push_back(ev);
+		}
+	}
+	e.type = type;
+	e.ob = ob;
+	e.seen = mGeneration;
+}
+
+void WORLDSTATE::Update(const PARSER &Parser)
+{
+	if (Parser.Arena.empty()) return;
+	// a new match starts from tick 0 again
+	if (Parser.tick < tick) Reset();
+	tick = Parser.tick;
+
+	ClearEvents();
+	++mGeneration;
+
+	Reconcile(UnitType::kHatchery, Parser.OwnHatchery);
+	Reconcile(UnitType::kEnemyHatchery, Parser.EnemyHatchery);
+	for (auto &ct : Parser.CreepTumors)
+	{
+		Reconcile(ct.IsEnemy() ? UnitType::kEnemyCreepTumor : UnitType::kCreepTumor, ct);
+	}
+	for (auto &u : Parser.Units)
+	{
+		Reconcile(u.IsEnemy() ? UnitType::kEnemyQueen : UnitType::kQueen, u);
+	}
+
+	// whatever wasn't in this frame died since the last one
+	for (auto it = mObjects.begin(); it != mObjects.end();)
+	{
+		const ENTRY &e = it->second;
+		if (e.seen == mGeneration)
+		{
+			++it;
+			continue;
+		}
+		WORLD_EVENT ev;
+		ev.id = it->first;
+		ev.type = e.type;
+		ev.from = ev.to = e.ob.pos;
+		ev.hp_lost = 0;
+		Died.push_back(ev);
+		it = mObjects.erase(it);
+	}
+}
+
+bool WORLDSTATE::IsAlive(int id) const
+{
+	return mObjects.count(id) != 0;
+}
+
+const MAP_OBJECT* WORLDSTATE::Find(int id) const
+{
+	auto it = mObjects.find(id);
+	return it == mObjects.end() ? NULL : &it->second.ob;
+}
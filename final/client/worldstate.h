@@ -0,0 +1,49 @@
+#pragma once
+#include "stdafx.h"
+
+#include <unordered_map>
+
+#include "parser.h"
+
+// Keeps the objects of the previous tick and reconciles every parsed frame
+// against them by id, so the heuristics can tell what changed without
+// rescanning everything.
+struct WORLD_EVENT
+{
+	int id;
+	UnitType type;
+	POS from, to; // the same but for Moved, where it was last seen for Died
+	int hp_lost; // Damaged only
+};
+
+class WORLDSTATE
+{
+public:
+	WORLDSTATE();
+	void Update(const PARSER &Parser);
+	void Reset();
+
+	bool IsAlive(int id) const;
+	const MAP_OBJECT* Find(int id) const;
+
+	int tick;
+	// in the last Update
+	std::vector<WORLD_EVENT> Spawned;
+	std::vector<WORLD_EVENT> Died;
+	std::vector<WORLD_EVENT> Moved;
+	std::vector<WORLD_EVENT> Damaged;
+	std::vector<WORLD_EVENT> TumorActivated;
+
+private:
+	struct ENTRY
+	{
+		UnitType type;
+		MAP_OBJECT ob;
+		int seen; // generation this object was last seen in
+	};
+	void Reconcile(UnitType type, const MAP_OBJECT &ob);
+	void ClearEvents();
+
+	int mGeneration;
+	std::unordered_map<int, ENTRY> mObjects; // by id, only the live ones
+};
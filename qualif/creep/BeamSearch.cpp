@@ -0,0 +1,206 @@
+#include "BeamSearch.hpp"
+#include "ThreadPool.hpp"
+
+#include <unordered_set>
+
+namespace {
+
+// the commands of a state, as a chain of steps
+struct Step {
+    int parent; // -1 for the first one
+    Command command;
+};
+
+struct BeamState {
+    std::unique_ptr<game> state;
+    int lastStep = -1;
+    long long score = 0;
+};
+
+struct Child {
+    int parent; // in the beam
+    Command command;
+    long long score;
+    std::uint64_t hash;
+};
+
+// every edge cell of every available tumor, and of the first available
+// queen, they are all alike
+void legalMoves(const game& g, std::vector<Command>& moves) {
+    std::vector<pos> cells;
+    for (int i = 0; i < g.tumor_count; ++i) {
+        if (!g.tumor_active[i] || g.tumor_cooldown_q8[i] > 0) {
+            continue;
+        }
+        cells.clear();
+        g.edge_cells_around(cells, g.tumor_pos[i]);
+        if (cells.empty()) {
+            cells.push_back(g.a_creep_cell_around(g.tumor_pos[i]));
+        }
+        for (auto& p : cells) {
+            if (g.valid_pos(p)) {
+                moves.push_back(Command::TumorSpawn(g.tumor_id[i], p.x, p.y));
+            }
+        }
+    }
+    int q = g.available_queen();
+    if (q >= 0) {
+        cells.clear();
+        g.edge_cells(cells);
+        if (cells.empty()) {
+            cells.push_back(g.a_creep_cell());
+        }
+        for (auto& p : cells) {
+            if (g.valid_pos(p)) {
+                moves.push_back(Command::QueenSpawn(g.queen_id[q], p.x, p.y));
+            }
+        }
+    }
+}
+
+// Creep cover, the buildings that still have somewhere to spread, the
+// cells creep may spread to now, and the cells in reach of a building
+// without creep yet.
+long long heuristic(const game& g) {
+    long long growing = 0;
+    row_bits wave[creep_disc_size];
+    for (int b = 0; b < g.building_count(); ++b) {
+        if (g.creep_wave(b, wave)) {
+            ++growing;
+        }
+    }
+    long long frontier = 0;
+    long long reach = 0;
+    for (int y = 0; y < g.map_dy; ++y) {
+        frontier += bit_count(g.creep_frontier(y) & g.map_creep_gen[y]);
+        reach += bit_count(g.map_creep_gen[y] & ~g.map_creep[y] & ~g.map_blocked[y]);
+    }
+    return 8 * g.creep_cover + 8 * growing + frontier + 4 * reach;
+}
+
+template<typename T, typename Better>
+void keepBest(std::vector<T>& items, std::size_t width, Better better) {
+    if (items.size() > width) {
+        std::nth_element(items.begin(), items.begin() + width, items.end(), better);
+        items.resize(width);
+    }
+    std::sort(items.begin(), items.end(), better);
+}
+
+} // anonymous namespace
+
+BeamResult beamSearch(const game& start, int width) {
+    auto& pool = ThreadPool::instance();
+    std::vector<Step> steps;
+    std::vector<BeamState> beam(1);
+    beam[0].state = start.clone();
+
+    const game* done = nullptr;
+    int doneStep = -1;
+    BeamResult result;
+    while (!done) {
+        // the commands of this tick, one round per command
+        std::vector<BeamState> candidates;
+        std::vector<BeamState> round = std::move(beam);
+        while (!round.empty()) {
+            std::vector<std::vector<Child>> perState(round.size());
+            pool.run(round.size(), [&](int, int i) {
+                const game& g = *round[i].state;
+                if (!g.hasValidMove()) {
+                    return;
+                }
+                std::vector<Command> moves;
+                legalMoves(g, moves);
+                auto scratch = g.clone();
+                for (auto& move : moves) {
+                    std::memcpy(static_cast<game_state*>(scratch.get()),
+                        static_cast<const game_state*>(&g), sizeof(game_state));
+                    executeCommand(*scratch, move);
+                    perState[i].push_back(
+                        {i, move, heuristic(*scratch), scratch->layout_hash()});
+                }
+            });
+
+            std::vector<Child> children;
+            // the same spawns made in another order count once
+            std::unordered_set<std::uint64_t> seen;
+            for (auto& state : round) {
+                seen.insert(state.state->layout_hash());
+            }
+            for (auto& list : perState) {
+                for (auto& child : list) {
+                    if (seen.insert(child.hash).second) {
+                        children.push_back(child);
+                    }
+                }
+            }
+            result.expanded += children.size();
+            std::stable_sort(children.begin(), children.end(),
+                [](const Child& a, const Child& b) {
+                    return a.score > b.score;
+                });
+            // no parent takes more than half of the beam, or one good
+            // state crowds out the rest
+            int perParent = std::max(1, width / 2);
+            std::vector<int> taken(round.size());
+            std::vector<Child> kept;
+            for (auto& child : children) {
+                if (int(kept.size()) == width) {
+                    break;
+                }
+                if (taken[child.parent]++ < perParent) {
+                    kept.push_back(child);
+                }
+            }
+            children = std::move(kept);
+
+            std::vector<BeamState> next;
+            for (auto& child : children) {
+                BeamState s;
+                s.state = round[child.parent].state->clone();
+                Command command = child.command;
+                command.t = s.state->t_q2;
+                executeCommand(*s.state, command);
+                steps.push_back({round[child.parent].lastStep, command});
+                s.lastStep = steps.size() - 1;
+                s.score = child.score;
+                next.push_back(std::move(s));
+            }
+            for (auto& state : round) {
+                candidates.push_back(std::move(state));
+            }
+            round = std::move(next);
+        }
+
+        for (auto& s : candidates) {
+            s.score = heuristic(*s.state);
+        }
+        keepBest(candidates, width, [](const BeamState& a, const BeamState& b) {
+            return a.score > b.score;
+        });
+        beam = std::move(candidates);
+
+        pool.run(beam.size(), [&](int, int i) {
+            beam[i].state->tick();
+        });
+        for (auto& s : beam) {
+            if (s.state->creep_finished() || s.state->t_q2 >= s.state->t_limit_q2) {
+                if (!done || s.state->creep_cover > done->creep_cover) {
+                    done = s.state.get();
+                    doneStep = s.lastStep;
+                }
+            }
+        }
+    }
+
+    for (int i = doneStep; i >= 0; i = steps[i].parent) {
+        result.commands.push_back(steps[i].command);
+    }
+    std::reverse(result.commands.begin(), result.commands.end());
+    // creep stops once the last command is played and nothing spreads,
+    // which can be before the state got finished
+    auto scored = playCommands(start, result.commands);
+    result.tick = scored->t_q2;
+    result.cover = scored->creep_cover;
+    return result;
+}
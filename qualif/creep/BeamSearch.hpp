@@ -0,0 +1,24 @@
+#pragma once
+
+#include "creep2.hh"
+#include "Command.hpp"
+
+#include <vector>
+
+// The beam holds `width` states, all at the same tick. At every tick each
+// state may take any number of commands: a round expands every legal tumor
+// and queen spawn of the states that still have a valid move and keeps the
+// best `width` children, no more than half of them from the same parent,
+// until no state has one left. The best `width` of everything seen in the
+// rounds then tick once. States are ranked by a cheap heuristic of creep
+// cover and spread potential, so no rollouts are played. The plan is the
+// first state where creep_finished() holds, and its tick and cover are the
+// ones creep scores the plan with. Expansion runs on the thread pool.
+struct BeamResult {
+    std::vector<Command> commands; // stamped with their tick
+    int tick = 0;
+    int cover = 0;
+    long long expanded = 0; // states
+};
+
+BeamResult beamSearch(const game& start, int width);
@@ -0,0 +1,101 @@
+#include "Command.hpp"
+#include "creep2.hh"
+
+void executeCommand(game& g, const Command& command) {
+    if (command.command <= 0) {
+        g.tick();
+    } else {
+        int cmd = command.command;
+        int id = command.id;
+        int x = command.x;
+        int y = command.y;
+        if (cmd == 1) {
+            g.queen_spawn_creep_tumor(g.get_queen(id),pos(x,y));
+        } else if (cmd == 2) {
+            g.creep_tumor_spawn_creep_tumor(g.get_creep_tumor(id),pos(x,y));
+        } else {
+            assert(0 && "invalid cmd code");
+        }
+    }
+}
+
+std::unique_ptr<game> playCommands(const game& start,
+    const std::vector<Command>& commands)
+{
+    auto g = start.clone();
+    for (auto& command : commands) {
+        while (g->t_q2 < command.t && g->t_q2 < g->t_limit_q2) {
+            g->tick();
+        }
+        if (g->t_q2 >= g->t_limit_q2) {
+            break;
+        }
+        executeCommand(*g, command);
+    }
+    while (g->anything_to_do() && g->t_q2 < g->t_limit_q2) {
+        g->tick();
+    }
+    return g;
+}
+
+std::vector<Command> LoadCommands(const std::string& file) {
+    std::vector<Command> commands;
+    std::ifstream in(file);
+
+    int count;
+    in >> count;
+    int last_command = 0;
+    for (int i = 0; i < count; ++i) {
+        Command cmd;
+        in >> cmd.t >> cmd.command >> cmd.id >> cmd.x >> cmd.y;
+        for (int j = last_command; j < cmd.t; ++j) {
+            commands.push_back(Command{});
+            commands.back().t = j;
+            last_command = cmd.t;
+        }
+        commands.push_back(cmd);
+    }
+    return commands;
+}
+
+std::vector<pos> GetQueenSpawnablePositions(const game& game) {
+    std::vector<pos> result;
+    for(uint y = 0; y < game.map_dy; ++y) {
+        for(uint x = 0; x < game.map_dx; ++x) {
+            auto p = pos(x, y);
+            if (game.valid_pos(p) &&
+                !game.wall_at(p) &&
+                !game.building_on(p) &&
+                game.creep_at(p))
+            {
+                result.push_back(p);
+            }
+        }
+    }
+    return result;
+}
+
+Command GetCommand(const game& game, std::minstd_rand& rng) {
+    for (int i = 0; i < game.tumor_count; ++i) {
+        if (!game.tumor_active[i]) {
+            // inactive
+        } else if (game.tumor_cooldown_q8[i] > 0) {
+            // cooldown
+        } else {
+            // available
+        }
+    }
+
+    for (int i = 0; i < game.queen_count; ++i) {
+        if (game.queen_energy_q8[i] < spawn_creep_tumor_energy_cost_q8) {
+            // charging
+        } else {
+            auto spawnable_pos = GetQueenSpawnablePositions(game);
+            std::uniform_int_distribution<> dis(0, spawnable_pos.size() - 1);
+            auto p = spawnable_pos[dis(rng)];
+
+            return Command::QueenSpawn(game.queen_id[i], p.x, p.y);
+        }
+    }
+    return Command{};
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct Command {
+    Command() = default;
+
+    static Command QueenSpawn(int id, int x, int y) {
+        Command cmd;
+        cmd.command = 1;
+        cmd.id = id;
+        cmd.x = x;
+        cmd.y = y;
+        return cmd;
+    }
+
+    static Command TumorSpawn(int id, int x, int y) {
+        Command cmd;
+        cmd.command = 2;
+        cmd.id = id;
+        cmd.x = x;
+        cmd.y = y;
+        return cmd;
+    }
+
+    int t = -1;
+    int command = -1;
+    int id;
+    int x;
+    int y;
+};
+
+// reads a command file, with a Command{} for every tick between commands
+std::vector<Command> LoadCommands(const std::string& file);
@@ -0,0 +1,66 @@
+#include "CommandHistory.hpp"
+
+CommandHistory::CommandHistory(const game& initial, int checkpointInterval)
+    : checkpointInterval(std::max(1, checkpointInterval))
+    , current(initial.clone())
+{
+    checkpoints.push_back({0, initial.clone()});
+}
+
+void CommandHistory::execute(const Command& command) {
+    undone.clear();
+    Command stamped = command;
+    stamped.t = current->t_q2;
+    append(stamped);
+}
+
+void CommandHistory::append(const Command& command) {
+    done.push_back(command);
+    executeCommand(*current, command);
+    if (command.command <= 0 && current->t_q2 % checkpointInterval == 0) {
+        checkpoints.push_back({done.size(), current->clone()});
+    }
+}
+
+bool CommandHistory::undo() {
+    std::size_t length = done.size();
+    while (length > 0 && done[length - 1].command <= 0) {
+        --length;
+    }
+    if (length > 0) {
+        --length;
+    }
+    if (length == done.size()) {
+        return false;
+    }
+    undone.insert(undone.end(), done.rbegin(), done.rend() - length);
+    truncate(length);
+    return true;
+}
+
+bool CommandHistory::redo() {
+    if (undone.empty()) {
+        return false;
+    }
+    while (!undone.empty() && undone.back().command <= 0) {
+        append(undone.back());
+        undone.pop_back();
+    }
+    if (!undone.empty()) {
+        append(undone.back());
+        undone.pop_back();
+    }
+    return true;
+}
+
+void CommandHistory::truncate(std::size_t length) {
+    while (checkpoints.back().length > length) {
+        checkpoints.pop_back();
+    }
+    const Checkpoint& from = checkpoints.back();
+    current = from.state->clone();
+    done.resize(length);
+    for (std::size_t i = from.length; i < length; ++i) {
+        executeCommand(*current, done[i]);
+    }
+}
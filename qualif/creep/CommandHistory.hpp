@@ -0,0 +1,38 @@
+#pragma once
+
+#include "creep2.hh"
+
+#include <memory>
+#include <vector>
+
+// The commands executed so far, with undo and redo. The state is cloned
+// every `checkpointInterval` ticks, so undoing replays at most that many
+// ticks instead of the whole game from the map file.
+class CommandHistory {
+public:
+    explicit CommandHistory(const game& initial, int checkpointInterval = 32);
+
+    const game& state() const { return *current; }
+    const std::vector<Command>& commands() const { return done; }
+
+    // stamps the command with the current tick, drops the redo list
+    void execute(const Command& command);
+    // takes back the ticks at the end and the command before them
+    bool undo();
+    bool redo();
+
+private:
+    struct Checkpoint {
+        std::size_t length; // commands executed before it
+        std::unique_ptr<game> state;
+    };
+
+    void append(const Command& command);
+    void truncate(std::size_t length);
+
+    int checkpointInterval;
+    std::unique_ptr<game> current;
+    std::vector<Command> done;
+    std::vector<Command> undone; // the next redo is at the back
+    std::vector<Checkpoint> checkpoints; // the first one is the initial state
+};
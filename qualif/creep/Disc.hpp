@@ -0,0 +1,63 @@
+#pragma once
+
+// Cells in a radius r around a cell, by the rule of the game: the circle is
+// drawn around the center of the cell, and a cell is inside when its center
+// is, measured in quarter cells (q2):
+//     dx_q1=2*dx+(0<dx?1:-1), dy_q1=2*dy+(0<dy?1:-1)
+//     dx_q1*dx_q1+dy_q1*dy_q1<=r*r*4
+// The test only depends on |dx| and |dy| and is monotone in both, so every
+// row of a disc is a single span |dx|<=disc_span(r,|dy|). The spans of the
+// radii 1..disc_max_radius are tabled at compile time.
+
+int const disc_max_radius=10;
+
+struct disc_span_table
+{
+    // span[r][ady], for ady<r
+    int span[disc_max_radius+1][disc_max_radius];
+    constexpr disc_span_table(): span()
+    {
+        for(int r=1; r<=disc_max_radius; ++r)
+            for(int ady=0; ady<r; ++ady)
+            {
+                int w=-1;
+                while(w+1<r && (2*w+3)*(2*w+3)+(2*ady+1)*(2*ady+1)<=r*r*4)
+                    ++w;
+                span[r][ady]=w;
+            }
+    }
+};
+
+constexpr disc_span_table disc_spans{};
+
+// the row dy of the radius r disc is dx in [-disc_span, disc_span], -1 if
+// the row is empty
+constexpr int disc_span(int r, int dy)
+{
+    int ady=dy<0?-dy:dy;
+    return ady<r ? disc_spans.span[r][ady] : -1;
+}
+
+constexpr bool in_disc(int dx, int dy, int r)
+{
+    return (dx<0?-dx:dx)<=disc_span(r,dy);
+}
+
+// the formula itself, and in_disc agrees with it
+constexpr bool in_disc_q2(int dx, int dy, int r)
+{
+    int dx_q1=2*dx+(0<dx?1:-1);
+    int dy_q1=2*dy+(0<dy?1:-1);
+    return dx_q1*dx_q1+dy_q1*dy_q1<=r*r*4;
+}
+
+constexpr bool disc_spans_agree()
+{
+    for(int r=1; r<=disc_max_radius; ++r)
+        for(int dy=-r-1; dy<=r+1; ++dy)
+            for(int dx=-r-1; dx<=r+1; ++dx)
+                if(in_disc(dx,dy,r)!=in_disc_q2(dx,dy,r))
+                    return false;
+    return true;
+}
+static_assert(disc_spans_agree(), "disc spans must match the q2 circle test");
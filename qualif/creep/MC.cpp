@@ -1,187 +1,305 @@
 #include "MC.hpp"
-#include "Util.hpp"
-
-#include <tuple>
-#include <thread>
-#include <future>
-
-using MCResult = std::tuple<sf::Vector2i, int>;
-using MCResults = std::vector<MCResult>;
-using MCResultsFuture = std::future<MCResults>;
-
-std::vector<std::minstd_rand> createRNGs(int count) {
-    std::vector<std::minstd_rand> rngs(count);
-    std::random_device rd;
-    for (auto& rng : rngs) {
-        auto seed = rd();
-        std::cerr << "RNG seed = " << seed << std::endl;
-        rng.seed(seed);
+#include "Rollout.hpp"
+#include "ThreadPool.hpp"
+#include "TranspositionTable.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <sstream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// rounds of halving until one of n is left
+int ceilLog2(int n) {
+    int rounds = 0;
+    while ((1 << rounds) < n) {
+        ++rounds;
     }
-    return rngs;
+    return rounds;
 }
 
-std::vector<std::minstd_rand> MonteCarlo::rngs = createRNGs(THREAD_COUNT);
+} // anonymous namespace
 
-MonteCarlo::MonteCarlo(game* g) : g(g->clone()) {}
+double MCProfile::rolloutsPerSecond() const {
+    return wall > 0 ? rollouts.rollouts / wall : 0;
+}
 
-Command MonteCarlo::getAutoMove() {
-    auto model = GuiModelFromGame(*g);
+double MCProfile::ticksPerSecond() const {
+    return wall > 0 ? rollouts.ticks / wall : 0;
+}
 
-    auto tumorPos = model.hasTumorMove();
-    if (model.isValidPosition(tumorPos)) {
-        int tumorId = boost::get<CreepTumor>(&model.tiles[tumorPos.x][tumorPos.y])->id;
-        auto candidates = model.getEdgeCellsAround(tumorPos, 10);
-        if (candidates.empty()) {
-            std::cerr << "no candidate for tumor move" << std::endl;
-            auto fb_pos = model.justACreepCellAround(tumorPos, 10);
-            return Command::TumorSpawn(tumorId, fb_pos.x, fb_pos.y);
-        }
+void MCProfile::print(std::ostream& os) const {
+    auto ms = [](double seconds) { return seconds * 1000; };
+    os << "MC " << kind << " " << candidates << " candidates, "
+        << rollouts.rollouts << " rollouts (" << reused << " reused) in "
+        << ms(wall) << " ms, " << rolloutsPerSecond() << " rollouts/s, "
+        << ticksPerSecond() << " ticks/s" << std::endl;
+    os << "MC " << kind << " ms: candidates " << ms(candidateGen)
+        << ", setup " << ms(setup)
+        << ", clone " << ms(rollouts.clone)
+        << ", move gen " << ms(rollouts.moveGen)
+        << ", execute " << ms(rollouts.execute)
+        << ", advance " << ms(rollouts.advance) << std::endl;
+    os << "MC " << kind << " utilisation:";
+    for (double b : busy) {
+        os << " " << int(wall > 0 ? 100 * b / wall : 0) << "%";
+    }
+    os << std::endl;
+}
 
-        auto job = [&](int ti) {
-            MCResults result;
-            auto cs = candidates.size();
-            int from = ti * cs / THREAD_COUNT;
-            int to = (ti + 1) * cs / THREAD_COUNT;
-            for (int i = from; i < cs && i < to; ++i) {
-                auto& candidate = candidates[i];
-                auto base = g->clone();
-                executeCommand(*base, Command::TumorSpawn(tumorId, candidate.x, candidate.y));
-                int score = doMCRun(base.get(), ti);
-
-                result.push_back({candidate, score});
-
-                std::cerr << "(" << ti << ") " << "T Candidate " << candidate
-                    << " " << i+1 << "/" << candidates.size()
-                    << " score = " << score << std::endl;
-            }
-            return result;
-        };
+std::string MCProfile::json() const {
+    std::ostringstream os;
+    os << "{\"kind\":\"" << kind << "\""
+        << ",\"candidates\":" << candidates
+        << ",\"rollouts\":" << rollouts.rollouts
+        << ",\"reused\":" << reused
+        << ",\"ticks\":" << rollouts.ticks
+        << ",\"commands\":" << rollouts.commands
+        << ",\"wall\":" << wall
+        << ",\"rollouts_per_s\":" << rolloutsPerSecond()
+        << ",\"ticks_per_s\":" << ticksPerSecond()
+        << ",\"candidate_gen\":" << candidateGen
+        << ",\"setup\":" << setup
+        << ",\"clone\":" << rollouts.clone
+        << ",\"move_gen\":" << rollouts.moveGen
+        << ",\"execute\":" << rollouts.execute
+        << ",\"advance\":" << rollouts.advance
+        << ",\"busy\":[";
+    for (std::size_t i = 0; i < busy.size(); ++i) {
+        os << (i ? "," : "") << busy[i];
+    }
+    os << "]}";
+    return os.str();
+}
 
-        std::vector<MCResultsFuture> resultFutures;
+void MonteCarlo::CandidateStats::add(int score) {
+    sum += score;
+    sumSq += (long long)score * score;
+    ++count;
+}
 
-        for (int i = 0; i < THREAD_COUNT; ++i) {
-            resultFutures.push_back(std::async(std::launch::async, job, i));
-        }
-        MCResults results;
-        for (int i = 0; i < THREAD_COUNT; ++i) {
-            MCResults result = resultFutures[i].get();
-            results.insert(results.end(), result.begin(), result.end());
-        }
+double MonteCarlo::CandidateStats::mean() const {
+    int n = count;
+    return n ? double(sum) / n : std::numeric_limits<double>::max();
+}
 
-        MCResult bestResult = {sf::Vector2i{-1, -1}, std::numeric_limits<int>::max()};
-        for (auto& result : results) {
-            if (std::get<1>(result) < std::get<1>(bestResult)) {
-                bestResult = result;
-            }
+double MonteCarlo::CandidateStats::confidence95() const {
+    int n = count;
+    if (n < 2) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double m = double(sum) / n;
+    double var = (double(sumSq) - n * m * m) / (n - 1);
+    return 1.96 * std::sqrt(std::max(0.0, var) / n);
+}
+
+MonteCarlo::MonteCarlo(const game* g, RolloutPolicy policy,
+    TranspositionTable* table)
+    : g(g->clone())
+    , policy(std::move(policy))
+    , table(table)
+{}
+
+TranspositionTable& MonteCarlo::sharedTable() {
+    static TranspositionTable table;
+    return table;
+}
+
+Command MonteCarlo::getAutoMove() {
+    auto start = Clock::now();
+    profile = MCProfile{};
+    Command move = chooseMove();
+    profile.wall = secondsSince(start);
+    if (!profile.kind.empty()) {
+        profile.print(std::cerr);
+        if (const char* file = std::getenv("MC_PROFILE_JSON")) {
+            std::ofstream(file, std::ios::app) << profile.json() << std::endl;
         }
+    }
+    return move;
+}
 
-        return Command::TumorSpawn(
-            tumorId, std::get<0>(bestResult).x, std::get<0>(bestResult).y);
-    } else if (model.hasQueenMove()) {
-        int queenId = model.getFreeQueenId();
-        auto candidates = model.getEdgeCells();
-        sf::Vector2i target;
+Command MonteCarlo::chooseMove() {
+    auto start = Clock::now();
+    int tumor = g->available_tumor();
+    if (tumor >= 0) {
+        int tumorId = g->tumor_id[tumor];
+        pos tumorPos = g->tumor_pos[tumor];
+        std::vector<pos> candidates;
+        g->edge_cells_around(candidates, tumorPos);
+        profile.candidateGen = secondsSince(start);
+        if (candidates.empty()) {
+            std::cerr << "no candidate for tumor move" << std::endl;
+            auto fb_pos = g->a_creep_cell_around(tumorPos);
+            return Command::TumorSpawn(tumorId, fb_pos.x, fb_pos.y);
+        }
+        auto best = bestCandidate(candidates, [&](const pos& p) {
+            return Command::TumorSpawn(tumorId, p.x, p.y);
+        }, "T");
+        return Command::TumorSpawn(tumorId, best.x, best.y);
+    } else if (g->available_queen() >= 0) {
+        int queenId = g->queen_id[g->available_queen()];
+        std::vector<pos> candidates;
+        g->edge_cells(candidates);
+        profile.candidateGen = secondsSince(start);
         if (candidates.empty()) {
             std::cerr << "no candidate for queen move" << std::endl;
-            auto fb_pos = model.justACreepCell();
+            auto fb_pos = g->a_creep_cell();
             return Command::QueenSpawn(queenId, fb_pos.x, fb_pos.y);
         }
+        auto best = bestCandidate(candidates, [&](const pos& p) {
+            return Command::QueenSpawn(queenId, p.x, p.y);
+        }, "Q");
+        return Command::QueenSpawn(queenId, best.x, best.y);
+    } else {
+        return Command{};
+    }
+}
 
-        auto job = [&](int ti) {
-            MCResults result;
-            auto cs = candidates.size();
-            int from = ti * cs / THREAD_COUNT;
-            int to = (ti + 1) * cs / THREAD_COUNT;
-            for (int i = from; i < cs && i < to; ++i) {
-                auto& candidate = candidates[i];
-                auto base = g->clone();
-                executeCommand(*base, Command::QueenSpawn(queenId, candidate.x, candidate.y));
-                int score = doMCRun(base.get(), ti);
-
-                result.push_back({candidate, score});
-
-                std::cerr << "(" << ti << ") " << "Q Candidate " << candidate
-                    << " " << i+1 << "/" << candidates.size()
-                    << " score = " << score << std::endl;
-            }
-            return result;
-        };
+pos MonteCarlo::bestCandidate(const std::vector<pos>& candidates,
+    const CommandFor& commandFor, const char* kind)
+{
+    auto start = Clock::now();
+    int cs = candidates.size();
+    std::vector<std::unique_ptr<game>> bases;
+    for (auto& candidate : candidates) {
+        bases.push_back(g->clone());
+        executeCommand(*bases.back(), commandFor(candidate));
+    }
+    profile.kind = kind;
+    profile.candidates = cs;
+    profile.setup = secondsSince(start);
 
-        std::vector<MCResultsFuture> resultFutures;
+    auto deadline = start + std::chrono::milliseconds(MC_TIME_MS);
+    auto timeUp = [&]() {
+        return MC_TIME_MS > 0 && Clock::now() >= deadline;
+    };
+    auto& pool = ThreadPool::instance();
+    std::vector<RolloutProfile> workerProfiles(pool.size());
 
-        for (int i = 0; i < THREAD_COUNT; ++i) {
-            resultFutures.push_back(std::async(std::launch::async, job, i));
+    // Successive halving: every round spends an even share of what is left
+    // of MC_BUDGET on the survivors, then drops the worse half of them by
+    // mean score. A round gives every survivor at least MC_MIN_SAMPLES
+    // rollouts, so nobody is dropped on a single noisy one, and no
+    // candidate gets more than MC_ITER, the old fixed amount. The budget is
+    // never exceeded: if it runs out before a round is done, the best mean
+    // of the survivors wins.
+    // Rollout j of a candidate plays the stream (position hash, j), and the
+    // results are recorded in task order, so the outcome doesn't depend on
+    // the thread count unless MC_TIME_MS cuts a round short. Rollouts from
+    // the same position in earlier decisions count too, and cost nothing of
+    // the budget; the new ones go on with the streams after them.
+    std::vector<CandidateStats> stats(cs);
+    std::vector<std::uint64_t> keys(cs);
+    int rolloutsReused = 0;
+    for (int i = 0; i < cs; ++i) {
+        keys[i] = bases[i]->hash();
+        TranspositionTable::Stats known;
+        if (table && table->find(keys[i], known)) {
+            stats[i].count = known.count;
+            stats[i].sum = known.sum;
+            stats[i].sumSq = known.sumSq;
+            rolloutsReused += known.count;
+        }
+    }
+    std::vector<int> alive(cs);
+    std::iota(alive.begin(), alive.end(), 0);
+    int const minSamples = std::min(MC_MIN_SAMPLES, MC_ITER);
+    int remaining = MC_BUDGET;
+    while (alive.size() > 1 && remaining > 0 && !timeUp()) {
+        int survivors = alive.size();
+        int roundsLeft = ceilLog2(survivors);
+        int per = std::max(minSamples, remaining / (roundsLeft * survivors));
+        // round robin, so a budget that runs out is spread evenly
+        std::vector<std::pair<int, int>> tasks; // candidate, rollout index
+        for (int j = 0; j < per && int(tasks.size()) < remaining; ++j) {
+            for (int i : alive) {
+                int index = stats[i].count + j;
+                if (index < MC_ITER && int(tasks.size()) < remaining) {
+                    tasks.emplace_back(i, index);
+                }
+            }
         }
-        MCResults results;
-        for (int i = 0; i < THREAD_COUNT; ++i) {
-            MCResults result = resultFutures[i].get();
-            results.insert(results.end(), result.begin(), result.end());
+        if (tasks.empty()) {
+            break;
         }
-
-        MCResult bestResult = {sf::Vector2i{-1, -1}, std::numeric_limits<int>::max()};
-        for (auto& result : results) {
-            if (std::get<1>(result) < std::get<1>(bestResult)) {
-                bestResult = result;
+        remaining -= tasks.size();
+        std::vector<int> scores(tasks.size(), -1);
+        pool.run(tasks.size(), [&](int worker, int task) {
+            if (timeUp()) {
+                return;
+            }
+            auto taskStart = Clock::now();
+            int i = tasks[task].first;
+            auto rng = rolloutRNG(keys[i], tasks[task].second);
+            scores[task] = doMCRun(*bases[i], rng, workerProfiles[worker]);
+            workerProfiles[worker].busy += secondsSince(taskStart);
+        });
+        for (std::size_t task = 0; task < tasks.size(); ++task) {
+            if (scores[task] >= 0) {
+                int i = tasks[task].first;
+                stats[i].add(scores[task]);
+                if (table) {
+                    table->add(keys[i], scores[task]);
+                }
             }
         }
 
-        return Command::QueenSpawn(
-            queenId, std::get<0>(bestResult).x, std::get<0>(bestResult).y);
-    } else {
-        return Command{};
+        bool sampled = std::all_of(alive.begin(), alive.end(), [&](int i) {
+            return stats[i].count >= minSamples;
+        });
+        if (!sampled) {
+            break;
+        }
+        std::stable_sort(alive.begin(), alive.end(), [&](int a, int b) {
+            return stats[a].mean() < stats[b].mean();
+        });
+        alive.resize((alive.size() + 1) / 2);
+        std::sort(alive.begin(), alive.end());
     }
-}
-
-int MonteCarlo::doMCRun(game* base, int thread_index) {
-    int score = 0;
-    for (int i = 0; i < MC_ITER; ++i) {
-        auto mc_game = base->clone();
-        while (true) {
-            if (mc_game->t_q2 >= 1000 || !mc_game->has_empty()) {
-                score += mc_game->t_q2;
-                break;
-            }
-            if (!mc_game->hasValidMove()) {
-                executeCommand(*mc_game, Command{});
-                continue;
-            }
+    int spent = -rolloutsReused;
+    for (auto& s : stats) {
+        spent += s.count;
+    }
+    assert(spent <= MC_BUDGET && "successive halving over budget");
 
-            auto model = GuiModelFromGame(*mc_game);
-            auto tumorPos = model.hasTumorMove();
-            if (model.isValidPosition(tumorPos)) {
-                auto candidates = model.getEdgeCellsAround(tumorPos, 10);
-                sf::Vector2i target;
-                if (candidates.empty()) {
-                    target = model.justACreepCellAround(tumorPos, 10);
-                } else {
-                    std::uniform_int_distribution<> dis(0, candidates.size() - 1);
-                    target = candidates[dis(rngs[thread_index])];
-                }
-                executeCommand(*mc_game,
-                    Command::TumorSpawn(
-                        boost::get<CreepTumor>(&model.tiles[tumorPos.x][tumorPos.y])->id,
-                        target.x, target.y
-                    )
-                );
-            } else if (model.hasQueenMove()) {
-                auto candidates = model.getEdgeCells();
-                sf::Vector2i target;
-                if (candidates.empty()) {
-                    target = model.justACreepCell();
-                } else {
-                    std::uniform_int_distribution<> dis(0, candidates.size() - 1);
-                    target = candidates[dis(rngs[thread_index])];
-                }
-                executeCommand(*mc_game,
-                    Command::QueenSpawn(
-                        model.getFreeQueenId(),
-                        target.x, target.y
-                    )
-                );
-            } else {
-                assert(false);
-            }
+    int best = alive.front();
+    for (int i : alive) {
+        if (stats[i].mean() < stats[best].mean()) {
+            best = i;
         }
     }
-    return score;
+    for (int i = 0; i < cs; ++i) {
+        std::cerr << kind << " Candidate "
+            << "(" << candidates[i].x << ", " << candidates[i].y << ")"
+            << " " << i+1 << "/" << cs
+            << " rollouts = " << stats[i].count
+            << " score = " << stats[i].mean()
+            << " +- " << stats[i].confidence95()
+            << (i == best ? " *" : "") << std::endl;
+    }
+    profile.reused = rolloutsReused;
+    for (auto& worker : workerProfiles) {
+        profile.rollouts += worker;
+        profile.busy.push_back(worker.busy);
+    }
+    return candidates[best];
+}
+
+int MonteCarlo::doMCRun(const game& base, std::minstd_rand& rng,
+    RolloutProfile& profile) const
+{
+    auto start = Clock::now();
+    auto mc_game = base.clone();
+    profile.clone += secondsSince(start);
+    return playOut(*mc_game, policy, rng, &profile);
 }
@@ -1,21 +1,92 @@
 #pragma once
 
 #include "creep2.hh"
-#include "Model.hpp"
+#include "Command.hpp"
+#include "Rollout.hpp"
+#include "TranspositionTable.hpp"
 
+#include <functional>
 #include <random>
 
+// rollouts per decision, split between the successive halving rounds
+#ifndef MC_BUDGET
+#define MC_BUDGET 2000
+#endif
+// rollouts every candidate gets before it may be dropped
+#ifndef MC_MIN_SAMPLES
+#define MC_MIN_SAMPLES 4
+#endif
+// wall clock limit per decision in ms, 0: none
+#ifndef MC_TIME_MS
+#define MC_TIME_MS 0
+#endif
+// the moves the rollouts play
+#ifndef MC_ROLLOUT_POLICY
+#define MC_ROLLOUT_POLICY weightedRolloutPolicy()
+#endif
+
+// What a getAutoMove call cost. It is printed to stderr after every call,
+// and appended as a line of JSON to the file named by the MC_PROFILE_JSON
+// environment variable when that is set. Times are in seconds.
+struct MCProfile {
+    std::string kind; // T or Q, empty when there was nothing to do
+    int candidates = 0;
+    int reused = 0; // rollouts known from the transposition table
+    double wall = 0;
+    double candidateGen = 0; // edge cells of the candidates
+    double setup = 0; // cloning and executing the candidate commands
+    RolloutProfile rollouts; // summed over the workers
+    std::vector<double> busy; // per worker
+
+    double rolloutsPerSecond() const;
+    double ticksPerSecond() const;
+
+    void print(std::ostream& os) const;
+    std::string json() const;
+};
+
 class MonteCarlo {
 public:
-    MonteCarlo(game* g);
+    // table: rollout statistics by position hash, kept across decisions,
+    // nullptr for none. It must only ever hold rollouts of this policy.
+    explicit MonteCarlo(const game* g,
+        RolloutPolicy policy = MC_ROLLOUT_POLICY,
+        TranspositionTable* table = &sharedTable());
+
+    // the MC_ROLLOUT_POLICY rollouts of every MonteCarlo, apart from the
+    // MCTS table: those leaf values are rollouts of MCTS's own policy
+    static TranspositionTable& sharedTable();
 
     Command getAutoMove();
+    const MCProfile& lastProfile() const { return profile; }
 private:
-    static const int THREAD_COUNT = 4;
+    using CommandFor = std::function<Command(const pos&)>;
 
-    int doMCRun(game* base, int thread_index);
+    // final tick statistics of the rollouts after a candidate command
+    struct CandidateStats {
+        int count = 0;
+        long long sum = 0;
+        long long sumSq = 0;
 
-    std::unique_ptr<game> g;
+        void add(int score);
+        double mean() const;
+        // half width of the 95% confidence interval of the mean
+        double confidence95() const;
+    };
+
+    // rollouts after each candidate command, the lowest mean final tick wins
+    pos bestCandidate(const std::vector<pos>& candidates,
+        const CommandFor& commandFor, const char* kind);
+
+    Command chooseMove();
 
-    static std::vector<std::minstd_rand> rngs;
+    // plays the rollout policy until the map is covered, returns the final
+    // tick
+    int doMCRun(const game& base, std::minstd_rand& rng,
+        RolloutProfile& profile) const;
+
+    std::unique_ptr<game> g;
+    RolloutPolicy policy;
+    TranspositionTable* table;
+    MCProfile profile;
 };
@@ -0,0 +1,185 @@
+#include "MCTS.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+int MCTS::NodeArena::allocate(int n) {
+    if (size() + n > capacity) {
+        return -1;
+    }
+    int first = size();
+    nodes.resize(size() + n);
+    return first;
+}
+
+void MCTS::NodeArena::keepSubtree(int root) {
+    std::vector<Node> kept;
+    kept.reserve(capacity);
+    kept.push_back(nodes[root]);
+    for (std::size_t i = 0; i < kept.size(); ++i) {
+        int first = kept[i].firstChild;
+        int count = kept[i].childCount;
+        if (count > 0) {
+            kept[i].firstChild = kept.size();
+            kept.insert(kept.end(),
+                nodes.begin() + first, nodes.begin() + first + count);
+        }
+    }
+    nodes.swap(kept);
+}
+
+MCTS::MCTS(RolloutPolicy policy, double exploration, int maxNodes,
+    TranspositionTable* table)
+    : policy(policy)
+    , exploration(exploration)
+    , arena(maxNodes)
+    , table(table)
+{}
+
+void MCTS::reset(const game& g) {
+    rootState = g.clone();
+    arena.clear();
+    arena.allocate(1);
+}
+
+Command MCTS::decide(const game& g, int iterations) {
+    if (isRolloutOver(g) || !g.hasValidMove()) {
+        return Command{};
+    }
+    if (!rootState || std::memcmp(static_cast<const game_state*>(rootState.get()),
+            static_cast<const game_state*>(&g), sizeof(game_state)) != 0)
+    {
+        reset(g);
+    }
+    int reused = arena[0].visits;
+    for (int i = 0; i < iterations; ++i) {
+        iterate();
+    }
+
+    const Node& root = arena[0];
+    int best = -1;
+    for (int i = 0; i < root.childCount; ++i) {
+        int child = root.firstChild + i;
+        if (best < 0 || arena[child].visits > arena[best].visits) {
+            best = child;
+        }
+    }
+    if (best < 0) {
+        return Command{};
+    }
+    Command move = arena[best].move;
+    std::cerr << "MCTS " << iterations << " iterations, " << reused
+        << " reused, " << arena.size() << " nodes, best visits = "
+        << arena[best].visits << " score = "
+        << arena[best].scoreSum / arena[best].visits << std::endl;
+
+    auto next = rootState->clone();
+    apply(*next, move);
+    arena.keepSubtree(best);
+    rootState = std::move(next);
+    return move;
+}
+
+void MCTS::apply(game& g, const Command& move) {
+    executeCommand(g, move);
+    if (!isRolloutOver(g)) {
+        g.advance_until_next_decision(rolloutHorizon);
+    }
+}
+
+void MCTS::expand(int node, const game& g) {
+    std::vector<Command> moves;
+    std::vector<pos> cells;
+    int tumor = g.available_tumor();
+    if (tumor >= 0) {
+        g.edge_cells_around(cells, g.tumor_pos[tumor]);
+        if (cells.empty()) {
+            cells.push_back(g.a_creep_cell_around(g.tumor_pos[tumor]));
+        }
+        for (auto& p : cells) {
+            moves.push_back(Command::TumorSpawn(g.tumor_id[tumor], p.x, p.y));
+        }
+    } else if (g.available_queen() >= 0) {
+        g.edge_cells(cells);
+        if (cells.empty()) {
+            cells.push_back(g.a_creep_cell());
+        }
+        int queenId = g.queen_id[g.available_queen()];
+        for (auto& p : cells) {
+            moves.push_back(Command::QueenSpawn(queenId, p.x, p.y));
+        }
+    }
+    moves.erase(std::remove_if(moves.begin(), moves.end(),
+        [&](const Command& c) { return !g.valid_pos(pos(c.x, c.y)); }),
+        moves.end());
+    moves.push_back(Command{}); // pass
+
+    int first = arena.allocate(moves.size());
+    if (first < 0) {
+        return; // full, the node stays a leaf
+    }
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        arena[first + i].move = moves[i];
+    }
+    arena[node].firstChild = first;
+    arena[node].childCount = moves.size();
+}
+
+int MCTS::select(int node) const {
+    const Node& parent = arena[node];
+    double logVisits = std::log(std::max(1, parent.visits));
+    int best = -1;
+    double bestValue = 0;
+    for (int i = 0; i < parent.childCount; ++i) {
+        int child = parent.firstChild + i;
+        const Node& n = arena[child];
+        if (n.visits == 0) {
+            return child;
+        }
+        // earlier full cover is better, rewards are in [0, 1]
+        double reward = 1.0 - n.scoreSum / n.visits / rolloutHorizon;
+        double value = reward + exploration * std::sqrt(logVisits / n.visits);
+        if (best < 0 || value > bestValue) {
+            best = child;
+            bestValue = value;
+        }
+    }
+    return best;
+}
+
+void MCTS::iterate() {
+    auto state = rootState->clone();
+    std::vector<int> path(1, 0);
+    int node = 0;
+    while (!isRolloutOver(*state)) {
+        if (arena[node].childCount == 0) {
+            // a leaf is expanded on its second visit
+            if (node != 0 && arena[node].visits == 0) {
+                break;
+            }
+            expand(node, *state);
+            if (arena[node].childCount == 0) {
+                break;
+            }
+        }
+        node = select(node);
+        apply(*state, arena[node].move);
+        path.push_back(node);
+        if (arena[node].visits == 0) {
+            break;
+        }
+    }
+    // the leaf may have been reached by another move order or search
+    std::uint64_t key = state->hash();
+    auto rng = rolloutRNG(key, rollouts++);
+    table->add(key, playOut(*state, policy, rng));
+    TranspositionTable::Stats known;
+    table->find(key, known);
+    double score = known.count ? double(known.sum) / known.count : state->t_q2;
+    for (int i : path) {
+        ++arena[i].visits;
+        arena[i].scoreSum += score;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Rollout.hpp"
+#include "TranspositionTable.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+// UCT search over the commands of the decision points, the states where
+// game::hasValidMove() holds. An edge is a command plus the ticks up to the
+// next decision point, pass is a single tick. Like getAutoMove, only the
+// first available tumor's spawns are considered if there is one, the
+// queen's otherwise.
+//
+// The subtree under the chosen move is kept, so if the next decide() gets
+// the state that move led to, its statistics carry over. Leaf values are
+// the mean of every rollout from that position in the transposition table.
+class MCTS {
+public:
+    explicit MCTS(RolloutPolicy policy = weightedRolloutPolicy(),
+        double exploration = 0.05, int maxNodes = 1 << 20,
+        TranspositionTable* table = &TranspositionTable::instance());
+
+    // Command{} if g is not a decision point
+    Command decide(const game& g, int iterations);
+
+    int nodeCount() const { return arena.size(); }
+    int rootVisits() const { return arena.empty() ? 0 : arena[0].visits; }
+
+private:
+    struct Node {
+        Command move; // from the parent
+        int firstChild = -1;
+        int childCount = 0;
+        int visits = 0;
+        double scoreSum = 0; // final ticks of the playouts through here
+    };
+
+    // Nodes in one vector, the children of a node are contiguous. Dropping
+    // everything but a subtree compacts it to the front.
+    class NodeArena {
+    public:
+        explicit NodeArena(int capacity) : capacity(capacity) {
+            nodes.reserve(capacity);
+        }
+        // first index of n new nodes, -1 if full
+        int allocate(int n);
+        void keepSubtree(int root);
+        void clear() { nodes.clear(); }
+        bool empty() const { return nodes.empty(); }
+        int size() const { return nodes.size(); }
+        Node& operator[](int i) { return nodes[i]; }
+        const Node& operator[](int i) const { return nodes[i]; }
+    private:
+        int capacity;
+        std::vector<Node> nodes;
+    };
+
+    void reset(const game& g);
+    void iterate();
+    void expand(int node, const game& g);
+    int select(int node) const;
+    // executes the move and ticks to the next decision point
+    static void apply(game& g, const Command& move);
+
+    RolloutPolicy policy;
+    double exploration;
+    NodeArena arena;
+    std::unique_ptr<game> rootState;
+    TranspositionTable* table;
+    std::uint64_t rollouts = 0; // rollout stream index
+};
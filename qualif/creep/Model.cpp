@@ -1,16 +1,59 @@
 #include "Model.hpp"
+#include "Disc.hpp"
+
+#include <algorithm>
 
 namespace {
 
-bool isEmptyCell(const Tile& tile) {
+bool isEmptyCell(Tile tile) {
     return
-        boost::get<Empty>(&tile) ||
-        boost::get<CreepCandidate>(&tile) ||
-        boost::get<CreepRadius>(&tile);
+        tile == Tile::Empty ||
+        tile == Tile::CreepCandidate ||
+        tile == Tile::CreepRadius;
 }
 
 } // anonymous namespace
 
+Model::Model(int tick, int max_tick, int columns, int rows,
+    std::vector<Tile> tiles, std::vector<CreepTumor> tumors,
+    std::vector<Queen> queens) :
+    tick(tick), max_tick(max_tick), columns(columns), rows(rows),
+    tiles(std::move(tiles)), tumors(std::move(tumors)),
+    queens(std::move(queens))
+{
+    for (auto& tumor : this->tumors) {
+        if (tumor.state == CreepTumor::State::Active) {
+            activeTumors.push_back(tumor.position);
+        }
+    }
+    for (auto tile : this->tiles) {
+        if (tile == Tile::CreepTumor || tile == Tile::Creep || tile == Tile::Hatchery) {
+            ++coveredCount;
+        } else if (isEmptyCell(tile)) {
+            ++emptyCount;
+        }
+    }
+    for (auto y = 1; y < rows-1; ++y) {
+        for (auto x = 1; x < columns-1; ++x) {
+            if (isCreepEdgeCell({x, y})) {
+                edgeCells.push_back({x, y});
+            }
+        }
+    }
+}
+
+const CreepTumor* Model::tumorAt(const sf::Vector2i& p) const {
+    auto it = std::lower_bound(tumors.begin(), tumors.end(), p,
+        [](const CreepTumor& tumor, const sf::Vector2i& p) {
+            return std::make_pair(tumor.position.y, tumor.position.x) <
+                std::make_pair(p.y, p.x);
+        });
+    if (it == tumors.end() || it->position != p) {
+        return nullptr;
+    }
+    return &*it;
+}
+
 bool Model::hasValidMove() const {
     return hasQueenMove() || isValidPosition(hasTumorMove());
 }
@@ -25,129 +68,63 @@ bool Model::hasQueenMove() const {
 }
 
 bool Model::isValidPosition(const sf::Vector2i& p) const {
-    auto columns = tiles.shape()[0];
-    auto rows = tiles.shape()[1];
-
     return p.x >= 0 && p.y >= 0 && p.x < columns && p.y < rows;
 }
 
 
 sf::Vector2i Model::hasTumorMove() const {
-    auto columns = tiles.shape()[0];
-    auto rows = tiles.shape()[1];
-
-    for (auto y = 0; y < rows; ++y) {
-        for (auto x = 0; x < columns; ++x) {
-            auto* creepTumor = boost::get<CreepTumor>(&tiles[x][y]);
-            if (creepTumor && creepTumor->state == CreepTumor::State::Active) {
-                return sf::Vector2i{x, y};
-            }
-        }
+    if (activeTumors.empty()) {
+        return sf::Vector2i{-1, -1};
     }
-    return sf::Vector2i{-1, -1};
+    return activeTumors.front();
 }
 
 int Model::getCoveredCount() const {
-    auto columns = tiles.shape()[0];
-    auto rows = tiles.shape()[1];
-
-    int covered = 0;
-    for (auto y = 0; y < rows; ++y) {
-        for (auto x = 0; x < columns; ++x) {
-            auto& t = tiles[x][y];
-            if (boost::get<CreepTumor>(&t) ||
-                boost::get<Creep>(&t) ||
-                boost::get<Hatchery>(&t))
-            {
-                ++covered;
-            }
-        }
-    }
-    return covered;
+    return coveredCount;
 }
 
 int Model::getEmptyCount() const {
-    auto columns = tiles.shape()[0];
-    auto rows = tiles.shape()[1];
-
-    int empty = 0;
-    for (auto y = 0; y < rows; ++y) {
-        for (auto x = 0; x < columns; ++x) {
-            if (isEmptyCell(tiles[x][y])) {
-                ++empty;
-            }
-        }
-    }
-    return empty;
+    return emptyCount;
 }
 
 std::vector<sf::Vector2i> Model::cellsAround(const sf::Vector2i& p, int radius) const {
     std::vector<sf::Vector2i> cells;
     for (int dy = -radius+1; dy < radius; ++dy) {
-        for(int dx = -radius+1; dx < radius; ++dx) {
-            sf::Vector2i cell(p.x + dx, p.y + dy);
-            if (!isValidPosition(cell)) {
-                continue;
-            }
-
-            int dx_q1 = 2*dx+(0<dx?1:-1);
-            int dy_q1 = 2*dy+(0<dy?1:-1);
-            int d2_q2 = dx_q1*dx_q1 + dy_q1*dy_q1;
-            if (d2_q2 <= radius*radius*4) {
-                cells.push_back(cell);
-            }
+        int y = p.y + dy;
+        if (y < 0 || y >= rows) {
+            continue;
+        }
+        int w = disc_span(radius, dy);
+        for (int x = std::max(0, p.x - w); x <= std::min(columns - 1, p.x + w); ++x) {
+            cells.push_back({x, y});
         }
     }
     return cells;
 }
 
 bool Model::isCreepEdgeCell(const sf::Vector2i& p) const {
-    if (!boost::get<Creep>(&tiles[p.x][p.y])) {
+    if (tileAt(p) != Tile::Creep) {
         return false;
     }
-    if (isEmptyCell(tiles[p.x+1][p.y]) ||
-        isEmptyCell(tiles[p.x-1][p.y]) ||
-        isEmptyCell(tiles[p.x][p.y+1]) ||
-        isEmptyCell(tiles[p.x][p.y-1]))
+    if (isEmptyCell(tileAt({p.x+1, p.y})) ||
+        isEmptyCell(tileAt({p.x-1, p.y})) ||
+        isEmptyCell(tileAt({p.x, p.y+1})) ||
+        isEmptyCell(tileAt({p.x, p.y-1})))
     {
         return true;
     }
     return false;
 }
 
-std::vector<sf::Vector2i> Model::getEdgeCells() const {
-    auto columns = tiles.shape()[0];
-    auto rows = tiles.shape()[1];
-
-    std::vector<sf::Vector2i> cells;
-    cells.reserve(50);
-
-    for (auto y = 1; y < rows-1; ++y) {
-        for (auto x = 1; x < columns-1; ++x) {
-            if (isCreepEdgeCell({x, y})) {
-                cells.push_back({x, y});
-            }
-        }
-    }
-
-    return cells;
+const std::vector<sf::Vector2i>& Model::getEdgeCells() const {
+    return edgeCells;
 }
 
 std::vector<sf::Vector2i> Model::getEdgeCellsAround(const sf::Vector2i& p, int radius) const {
     std::vector<sf::Vector2i> cells;
-    for (int dy = -radius+1; dy < radius; ++dy) {
-        for(int dx = -radius+1; dx < radius; ++dx) {
-            sf::Vector2i cell(p.x + dx, p.y + dy);
-            if (!isValidPosition(cell) || !isCreepEdgeCell(cell)) {
-                continue;
-            }
-
-            int dx_q1 = 2*dx+(0<dx?1:-1);
-            int dy_q1 = 2*dy+(0<dy?1:-1);
-            int d2_q2 = dx_q1*dx_q1 + dy_q1*dy_q1;
-            if (d2_q2 <= radius*radius*4) {
-                cells.push_back(cell);
-            }
+    for (auto& cell : edgeCells) {
+        if (in_disc(cell.x - p.x, cell.y - p.y, radius)) {
+            cells.push_back(cell);
         }
     }
     return cells;
@@ -163,13 +140,9 @@ int Model::getFreeQueenId() const {
 }
 
 sf::Vector2i Model::justACreepCell() const {
-    auto columns = tiles.shape()[0];
-    auto rows = tiles.shape()[1];
-
     for (auto y = 2; y < rows; ++y) {
         for (auto x = 2; x < columns; ++x) {
-            auto& t = tiles[x][y];
-            if (boost::get<Creep>(&t)) {
+            if (tileAt({x, y}) == Tile::Creep) {
                 return {x, y};
             }
         }
@@ -179,17 +152,14 @@ sf::Vector2i Model::justACreepCell() const {
 
 sf::Vector2i Model::justACreepCellAround(const sf::Vector2i& p, int radius) const {
     for (int dy = -radius+1; dy < radius; ++dy) {
-        for(int dx = -radius+1; dx < radius; ++dx) {
-            sf::Vector2i cell(p.x + dx, p.y + dy);
-            if (!isValidPosition(cell)) {
-                continue;
-            }
-
-            int dx_q1 = 2*dx+(0<dx?1:-1);
-            int dy_q1 = 2*dy+(0<dy?1:-1);
-            int d2_q2 = dx_q1*dx_q1 + dy_q1*dy_q1;
-            if (d2_q2 <= radius*radius*4 && boost::get<Creep>(&tiles[cell.x][cell.y])) {
-                return cell;
+        int y = p.y + dy;
+        if (y < 0 || y >= rows) {
+            continue;
+        }
+        int w = disc_span(radius, dy);
+        for (int x = std::max(0, p.x - w); x <= std::min(columns - 1, p.x + w); ++x) {
+            if (tileAt({x, y}) == Tile::Creep) {
+                return {x, y};
             }
         }
     }
@@ -200,12 +170,11 @@ TumorSpawnResult Model::canTumowSpawn(const sf::Vector2i& from, const sf::Vector
     if (!isValidPosition(from) || !isValidPosition(to)) {
         return TumorSpawnResult::INVALID_POSITION;
     }
-    auto* sourceTumor = boost::get<CreepTumor>(&tiles[from.x][from.y]);
-    auto* destCreep = boost::get<Creep>(&tiles[to.x][to.y]);
+    auto* sourceTumor = tumorAt(from);
     if (!sourceTumor) {
         return TumorSpawnResult::SOURCE_NOT_TUMOR;
     }
-    if (!destCreep) {
+    if (tileAt(to) != Tile::Creep) {
         return TumorSpawnResult::DEST_NOT_CREEP;
     }
 
@@ -213,10 +182,7 @@ TumorSpawnResult Model::canTumowSpawn(const sf::Vector2i& from, const sf::Vector
         return TumorSpawnResult::TUMOR_NOT_ACTIVE;
     }
 
-    auto candidateCells = cellsAround(from, 10);
-
-    auto it = std::find(begin(candidateCells), end(candidateCells), to);
-    if (it == end(candidateCells)) {
+    if (!in_disc(to.x - from.x, to.y - from.y, 10)) {
         return TumorSpawnResult::DEST_TOO_FAR_AWAY;
     }
 
@@ -1,19 +1,24 @@
 #pragma once
 
+#include "Command.hpp"
+
 #include <SFML/Graphics.hpp>
 
-#include <boost/variant.hpp>
-#include <boost/multi_array.hpp>
+#include <cstdint>
+#include <vector>
 
 struct game;
 
-struct Hatchery {};
-
-struct Wall {};
-
-struct Empty {};
-
-struct Creep {};
+// one byte per cell, the tumor details are in Model::tumors
+enum class Tile : std::uint8_t {
+    Empty,
+    Wall,
+    Hatchery,
+    CreepTumor,
+    Creep,
+    CreepCandidate,
+    CreepRadius
+};
 
 struct CreepTumor {
     enum class State {
@@ -22,27 +27,12 @@ struct CreepTumor {
         Active
     };
 
+    sf::Vector2i position{-1, -1};
     int id = -1;
     int cooldown = 0;
     State state;
 };
 
-struct CreepCandidate {};
-
-struct CreepRadius {};
-
-using Tile = boost::variant<
-    Empty,
-    Wall,
-    Hatchery,
-    CreepTumor,
-    Creep,
-    CreepCandidate,
-    CreepRadius
->;
-
-using TileMatrix = boost::multi_array<Tile, 2>;
-
 struct Queen {
     int id = -1;
     int energy = -1;
@@ -59,13 +49,27 @@ enum class TumorSpawnResult {
 
 struct Model {
     Model() = default;
-    Model(int tick, int max_tick, const TileMatrix& tiles, const std::vector<Queen>& queens) :
-        tick(tick), max_tick(max_tick), tiles(tiles), queens(queens) {}
+    // tiles are in row major order, tumors too
+    Model(int tick, int max_tick, int columns, int rows,
+        std::vector<Tile> tiles, std::vector<CreepTumor> tumors,
+        std::vector<Queen> queens);
     int tick = -1;
     int max_tick = -1;
-    TileMatrix tiles;
+    int columns = 0;
+    int rows = 0;
+    std::vector<Tile> tiles;
+    std::vector<CreepTumor> tumors;
     std::vector<Queen> queens;
-    game* game = nullptr;
+    const ::game* game = nullptr;
+
+    // filled by the constructor
+    std::vector<sf::Vector2i> edgeCells;
+    std::vector<sf::Vector2i> activeTumors;
+    int coveredCount = 0;
+    int emptyCount = 0;
+
+    Tile tileAt(const sf::Vector2i& p) const { return tiles[p.y * columns + p.x]; }
+    const CreepTumor* tumorAt(const sf::Vector2i& p) const;
 
     bool isValidPosition(const sf::Vector2i& p) const;
 
@@ -81,7 +85,7 @@ struct Model {
     std::vector<sf::Vector2i> cellsAround(const sf::Vector2i& p, int radius) const;
 
     bool isCreepEdgeCell(const sf::Vector2i& p) const;
-    std::vector<sf::Vector2i> getEdgeCells() const;
+    const std::vector<sf::Vector2i>& getEdgeCells() const;
     std::vector<sf::Vector2i> getEdgeCellsAround(const sf::Vector2i& p, int radius) const;
 
     sf::Vector2i justACreepCell() const;
@@ -89,31 +93,3 @@ struct Model {
 
     TumorSpawnResult canTumowSpawn(const sf::Vector2i& from, const sf::Vector2i& to) const;
 };
-
-struct Command {
-    Command() = default;
-
-    static Command QueenSpawn(int id, int x, int y) {
-        Command cmd;
-        cmd.command = 1;
-        cmd.id = id;
-        cmd.x = x;
-        cmd.y = y;
-        return cmd;
-    }
-
-    static Command TumorSpawn(int id, int x, int y) {
-        Command cmd;
-        cmd.command = 2;
-        cmd.id = id;
-        cmd.x = x;
-        cmd.y = y;
-        return cmd;
-    }
-
-    int t = -1;
-    int command = -1;
-    int id;
-    int x;
-    int y;
-};
@@ -0,0 +1,96 @@
+#include "RandomMap.hpp"
+
+#include <random>
+#include <vector>
+
+namespace {
+
+// open[y][x], y = 0 is the bottom row as in the game
+using Grid = std::vector<std::vector<bool>>;
+
+int wallsAround(const Grid& open, int x, int y) {
+    int walls = 0;
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            walls += !open[y + dy][x + dx];
+        }
+    }
+    return walls;
+}
+
+// walls up what can't be reached from (x, y), returns the open cells left
+int keepConnected(Grid& open, int x0, int y0) {
+    int height = open.size();
+    int width = open[0].size();
+    Grid seen(height, std::vector<bool>(width));
+    std::vector<std::pair<int, int>> stack{{x0, y0}};
+    int count = 0;
+    while (!stack.empty()) {
+        int x = stack.back().first;
+        int y = stack.back().second;
+        stack.pop_back();
+        if (!open[y][x] || seen[y][x]) {
+            continue;
+        }
+        seen[y][x] = true;
+        ++count;
+        stack.push_back({x + 1, y});
+        stack.push_back({x - 1, y});
+        stack.push_back({x, y + 1});
+        stack.push_back({x, y - 1});
+    }
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            open[y][x] = open[y][x] && seen[y][x];
+        }
+    }
+    return count;
+}
+
+} // anonymous namespace
+
+void writeRandomMap(std::ostream& out, std::uint32_t seed,
+    int width, int height, int timeLimit)
+{
+    std::mt19937 rng(seed);
+    Grid open;
+    int baseX, baseY;
+    do {
+        std::bernoulli_distribution start(0.6);
+        open.assign(height, std::vector<bool>(width));
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 1; x < width - 1; ++x) {
+                open[y][x] = start(rng);
+            }
+        }
+        for (int step = 0; step < 4; ++step) {
+            Grid next = open;
+            for (int y = 1; y < height - 1; ++y) {
+                for (int x = 1; x < width - 1; ++x) {
+                    next[y][x] = wallsAround(open, x, y) < 5;
+                }
+            }
+            open.swap(next);
+        }
+
+        // the hatchery takes the 3x3 cells from the base, with a free ring
+        // around it
+        baseX = std::uniform_int_distribution<>(2, width - 6)(rng);
+        baseY = std::uniform_int_distribution<>(2, height - 6)(rng);
+        for (int y = baseY - 1; y <= baseY + 3; ++y) {
+            for (int x = baseX - 1; x <= baseX + 3; ++x) {
+                open[y][x] = true;
+            }
+        }
+    // too small a cave makes a boring game
+    } while (keepConnected(open, baseX, baseY) < width * height / 3);
+
+    out << timeLimit << "\n" << width << " " << height << "\n";
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) {
+            out << (open[y][x] ? '.' : '#');
+        }
+        out << "\n";
+    }
+    out << baseX << " " << baseY << "\n";
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+// Writes a random map the game constructor accepts: walls all along the
+// border, a single connected open area and room for the hatchery at the
+// base. The caves come from a cellular automaton, then every open cell the
+// base can't reach is walled up. The same seed gives the same map.
+void writeRandomMap(std::ostream& out, std::uint32_t seed,
+    int width = 64, int height = 64, int timeLimit = 2500);
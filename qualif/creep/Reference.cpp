@@ -0,0 +1,218 @@
+#include "Reference.hpp"
+
+#include <sstream>
+
+// creep.cc's own includes first, so their guards keep them out of the
+// namespace
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#define main referenceMain
+namespace reference {
+#include "creep.cc"
+}
+#undef main
+
+namespace {
+
+std::uint64_t mix(std::uint64_t h, std::uint64_t value) {
+    h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+template<typename T>
+bool differ(std::ostream& os, const char* field, const T& a, const T& b) {
+    if (a == b) {
+        return false;
+    }
+    os << field << ": " << a << " vs " << b;
+    return true;
+}
+
+} // anonymous namespace
+
+std::uint64_t GameSnapshot::hash() const {
+    std::uint64_t h = 0;
+    for (int value : {tick, timeLimit, nextId, cover}) {
+        h = mix(h, value);
+    }
+    for (auto row : creep) {
+        h = mix(h, row);
+    }
+    for (auto row : creepGen) {
+        h = mix(h, row);
+    }
+    for (auto& b : buildings) {
+        for (int value : {b.id, b.x, b.y, b.size, b.active, b.cooldown}) {
+            h = mix(h, value);
+        }
+    }
+    for (auto& q : queens) {
+        h = mix(h, q.id);
+        h = mix(h, q.energy);
+    }
+    return h;
+}
+
+std::string firstDifference(const GameSnapshot& a, const GameSnapshot& b) {
+    std::ostringstream os;
+    if (differ(os, "tick", a.tick, b.tick) ||
+        differ(os, "time limit", a.timeLimit, b.timeLimit) ||
+        differ(os, "next id", a.nextId, b.nextId) ||
+        differ(os, "creep cover", a.cover, b.cover) ||
+        differ(os, "map height", a.creep.size(), b.creep.size()) ||
+        differ(os, "buildings", a.buildings.size(), b.buildings.size()) ||
+        differ(os, "queens", a.queens.size(), b.queens.size()))
+    {
+        return os.str();
+    }
+    for (std::size_t y = 0; y < a.creep.size(); ++y) {
+        auto row = a.creep[y] ^ b.creep[y];
+        auto gen = a.creepGen[y] ^ b.creepGen[y];
+        if (row || gen) {
+            os << (row ? "creep" : "creep gen") << " at (" <<
+                __builtin_ctzll(row ? row : gen) << "," << y << ")";
+            return os.str();
+        }
+    }
+    for (std::size_t i = 0; i < a.buildings.size(); ++i) {
+        auto& p = a.buildings[i];
+        auto& q = b.buildings[i];
+        os << "building " << i << " ";
+        if (differ(os, "id", p.id, q.id) ||
+            differ(os, "x", p.x, q.x) ||
+            differ(os, "y", p.y, q.y) ||
+            differ(os, "size", p.size, q.size) ||
+            differ(os, "active", p.active, q.active) ||
+            differ(os, "cooldown", p.cooldown, q.cooldown))
+        {
+            return os.str();
+        }
+        os.str("");
+    }
+    for (std::size_t i = 0; i < a.queens.size(); ++i) {
+        os << "queen " << i << " ";
+        if (differ(os, "id", a.queens[i].id, b.queens[i].id) ||
+            differ(os, "energy", a.queens[i].energy, b.queens[i].energy))
+        {
+            return os.str();
+        }
+        os.str("");
+    }
+    return {};
+}
+
+ReferenceGame::ReferenceGame(const std::string& mapFile)
+    : g(std::make_unique<reference::game>(mapFile.c_str()))
+{}
+
+ReferenceGame::~ReferenceGame() = default;
+
+void ReferenceGame::tick() {
+    g->tick();
+}
+
+bool ReferenceGame::anythingToDo() const {
+    return g->anything_to_do();
+}
+
+int ReferenceGame::currentTick() const {
+    return g->t_q2;
+}
+
+int ReferenceGame::timeLimit() const {
+    return g->t_limit_q2;
+}
+
+const char* ReferenceGame::commandError(int cmd, int id, int x, int y) const {
+    reference::pos p(x, y);
+    auto onCreep = [&] {
+        return g->valid_pos(p) && !g->map_wall[p.y][p.x] &&
+            !g->map_building[p.y][p.x] && g->map_creep[p.y][p.x];
+    };
+    if (cmd == 1) {
+        auto it = std::find_if(g->units.begin(), g->units.end(),
+            [&](reference::unit* u) { return u->id == id; });
+        if (it == g->units.end()) {
+            return "invalid id";
+        }
+        if ((*it)->energy_q8 < reference::queen::spawn_creep_tumor_energy_cost_q8) {
+            return "not enough energy";
+        }
+        return onCreep() ? nullptr : "not on creep";
+    }
+    if (cmd == 2) {
+        auto it = std::find_if(g->buildings.begin(), g->buildings.end(),
+            [&](reference::building* b) { return b->id == id; });
+        if (it == g->buildings.end()) {
+            return "invalid id";
+        }
+        auto* tumor = dynamic_cast<reference::creep_tumor*>(*it);
+        if (!tumor) {
+            return "not a creep tumor";
+        }
+        if (tumor->spawn_creep_tumor_active != 1) {
+            return "creep tumor not active";
+        }
+        if (tumor->dt_spawn_creep_tumor_cooldown_q8 != 0) {
+            return "spawn creep tumor cooldown";
+        }
+        if (!onCreep()) {
+            return "not on creep";
+        }
+        std::vector<reference::pos> cells;
+        g->valid_cells_in_a_radius(cells,
+            reference::pos(tumor->br.x0, tumor->br.y0),
+            reference::creep_tumor::spawn_creep_tumor_radius);
+        bool inRange = std::find(cells.begin(), cells.end(), p) != cells.end();
+        return inRange ? nullptr : "target too far";
+    }
+    return "invalid cmd code";
+}
+
+void ReferenceGame::execute(int cmd, int id, int x, int y) {
+    assert(!commandError(cmd, id, x, y));
+    if (cmd == 1) {
+        g->queen_spawn_creep_tumor(g->get_queen(id), reference::pos(x, y));
+    } else {
+        g->creep_tumor_spawn_creep_tumor(g->get_creep_tumor(id),
+            reference::pos(x, y));
+    }
+}
+
+GameSnapshot ReferenceGame::snapshot() const {
+    GameSnapshot s;
+    s.tick = g->t_q2;
+    s.timeLimit = g->t_limit_q2;
+    s.nextId = g->next_id;
+    s.cover = g->creep_cover;
+    s.creep.resize(g->map_dy);
+    s.creepGen.resize(g->map_dy);
+    for (int y = 0; y < g->map_dy; ++y) {
+        for (int x = 0; x < g->map_dx; ++x) {
+            s.creep[y] |= std::uint64_t(g->map_creep[y][x]) << x;
+            s.creepGen[y] |= std::uint64_t(g->map_creep_gen[y][x] > 0) << x;
+        }
+    }
+    for (auto* b : g->buildings) {
+        GameSnapshot::Building building{b->id, b->br.x0, b->br.y0,
+            b->br.x1 - b->br.x0, 0, 0};
+        if (auto* tumor = dynamic_cast<reference::creep_tumor*>(b)) {
+            building.active = tumor->spawn_creep_tumor_active;
+            building.cooldown = tumor->dt_spawn_creep_tumor_cooldown_q8;
+        }
+        s.buildings.push_back(building);
+    }
+    for (auto* u : g->units) {
+        s.queens.push_back({u->id, u->energy_q8});
+    }
+    return s;
+}
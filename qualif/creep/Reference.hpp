@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The state two simulators are compared by: everything the rules read,
+// flattened the same way for both. Health is left out, nothing deals damage
+// so it is always max.
+struct GameSnapshot {
+    struct Building {
+        int id;
+        int x, y; // bottom left corner
+        int size;
+        int active; // 0 for the hatchery
+        int cooldown; // q8, 0 for the hatchery
+    };
+    struct Queen {
+        int id;
+        int energy; // q8
+    };
+
+    int tick = 0;
+    int timeLimit = 0;
+    int nextId = 0;
+    int cover = 0;
+    // one bit per cell, bit x of row y
+    std::vector<std::uint64_t> creep;
+    std::vector<std::uint64_t> creepGen; // in the spread radius of a building
+    std::vector<Building> buildings; // in creation order, the hatchery first
+    std::vector<Queen> queens; // in creation order
+
+    std::uint64_t hash() const;
+};
+
+// the first field a and b differ in, empty if they are the same
+std::string firstDifference(const GameSnapshot& a, const GameSnapshot& b);
+
+namespace reference { struct game; }
+
+// The organisers' simulator, creep.cc, compiled as it is into a namespace of
+// its own, behind an interface that doesn't clash with creep2.hh. Invalid
+// commands are not executed: commandError tells what creep.cc would assert
+// on instead.
+class ReferenceGame {
+public:
+    explicit ReferenceGame(const std::string& mapFile);
+    ~ReferenceGame();
+
+    void tick();
+    bool anythingToDo() const;
+    int currentTick() const;
+    int timeLimit() const;
+
+    // nullptr if the command is valid
+    const char* commandError(int cmd, int id, int x, int y) const;
+    void execute(int cmd, int id, int x, int y);
+
+    GameSnapshot snapshot() const;
+
+private:
+    std::unique_ptr<reference::game> g;
+};
@@ -0,0 +1,186 @@
+#include "Rollout.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+std::uint64_t splitmix64(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+double priorWeight(const game& g, const RolloutPriors& priors, pos p) {
+    creep_disc const& disc = creep_disc::get();
+    int fresh = 0;
+    int open = 0;
+    for (int i = 0; i < creep_disc_size; ++i) {
+        int y = p.y - (creep_spread_radius - 1) + i;
+        if (y < 0 || g.map_dy <= y) {
+            continue;
+        }
+        row_bits in = disc.at(i, p.x) & g.row_mask() & ~g.map_wall[y];
+        open += bit_count(in);
+        fresh += bit_count(in & ~g.map_creep_gen[y]);
+    }
+    static const int area = []() {
+        int n = 0;
+        for (row_bits r : creep_disc::get().row) {
+            n += bit_count(r);
+        }
+        return n;
+    }();
+    double weight = std::max(1.0,
+        1 + priors.fresh * fresh - priors.walls * (area - open));
+    return std::pow(weight, priors.exponent);
+}
+
+// The priors change with every move and rollouts part ways after their
+// first one: an alias table cached by game::hash() was hit by 0.5-3.6% of
+// the draws, and the rollouts were 12-29% slower for it. So the weights
+// are computed for the one draw and it is a search over their running sums.
+pos weightedCell(const game& g, const RolloutPriors& priors,
+    const std::vector<pos>& cells, std::minstd_rand& rng)
+{
+    thread_local std::vector<double> sums;
+    sums.clear();
+    double sum = 0;
+    for (auto& p : cells) {
+        sum += priorWeight(g, priors, p);
+        sums.push_back(sum);
+    }
+    double r = std::uniform_real_distribution<>(0, sum)(rng);
+    auto it = std::upper_bound(sums.begin(), sums.end(), r);
+    return cells[std::min<std::size_t>(it - sums.begin(), cells.size() - 1)];
+}
+
+} // anonymous namespace
+
+RolloutProfile& RolloutProfile::operator+=(const RolloutProfile& other) {
+    rollouts += other.rollouts;
+    ticks += other.ticks;
+    commands += other.commands;
+    clone += other.clone;
+    moveGen += other.moveGen;
+    execute += other.execute;
+    advance += other.advance;
+    busy += other.busy;
+    return *this;
+}
+
+std::uint64_t masterSeed() {
+    static const std::uint64_t seed = []() {
+        const char* env = std::getenv("CREEP_SEED");
+        std::uint64_t seed = env ? std::strtoull(env, nullptr, 10)
+            : std::random_device{}();
+        std::cerr << "RNG seed = " << seed << std::endl;
+        return seed;
+    }();
+    return seed;
+}
+
+std::minstd_rand rolloutRNG(std::uint64_t key, std::uint64_t index) {
+    std::uint64_t x = splitmix64(splitmix64(masterSeed() ^ key) + index);
+    return std::minstd_rand(std::uint32_t(x >> 32));
+}
+
+bool isRolloutOver(const game& g) {
+    return g.t_q2 >= rolloutHorizon || !g.has_empty();
+}
+
+Command randomRolloutMove(const game& g, std::minstd_rand& rng) {
+    thread_local std::vector<pos> candidates;
+    candidates.clear();
+    int tumor = g.available_tumor();
+    if (tumor >= 0) {
+        pos tumorPos = g.tumor_pos[tumor];
+        g.edge_cells_around(candidates, tumorPos);
+        pos target;
+        if (candidates.empty()) {
+            target = g.a_creep_cell_around(tumorPos);
+        } else {
+            std::uniform_int_distribution<> dis(0, candidates.size() - 1);
+            target = candidates[dis(rng)];
+        }
+        return Command::TumorSpawn(g.tumor_id[tumor], target.x, target.y);
+    } else if (g.available_queen() >= 0) {
+        g.edge_cells(candidates);
+        pos target;
+        if (candidates.empty()) {
+            target = g.a_creep_cell();
+        } else {
+            std::uniform_int_distribution<> dis(0, candidates.size() - 1);
+            target = candidates[dis(rng)];
+        }
+        return Command::QueenSpawn(
+            g.queen_id[g.available_queen()], target.x, target.y);
+    }
+    assert(false);
+    return Command{};
+}
+
+RolloutPolicy weightedRolloutPolicy(RolloutPriors priors) {
+    return [priors](const game& g, std::minstd_rand& rng) {
+        thread_local std::vector<pos> candidates;
+        candidates.clear();
+        int tumor = g.available_tumor();
+        if (tumor >= 0) {
+            pos tumorPos = g.tumor_pos[tumor];
+            g.edge_cells_around(candidates, tumorPos);
+            pos target = candidates.empty()
+                ? g.a_creep_cell_around(tumorPos)
+                : weightedCell(g, priors, candidates, rng);
+            return Command::TumorSpawn(g.tumor_id[tumor], target.x, target.y);
+        }
+        assert(g.available_queen() >= 0);
+        g.edge_cells(candidates);
+        pos target = candidates.empty()
+            ? g.a_creep_cell()
+            : weightedCell(g, priors, candidates, rng);
+        return Command::QueenSpawn(
+            g.queen_id[g.available_queen()], target.x, target.y);
+    };
+}
+
+int playOut(game& g, const RolloutPolicy& policy, std::minstd_rand& rng,
+    RolloutProfile* profile)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point last;
+    // adds the time since the previous lap to the field
+    auto lap = [&](double& field) {
+        auto now = Clock::now();
+        field += std::chrono::duration<double>(now - last).count();
+        last = now;
+    };
+    int start = g.t_q2;
+    if (profile) {
+        last = Clock::now();
+    }
+    while (!isRolloutOver(g)) {
+        if (!g.hasValidMove()) {
+            g.advance_until_next_decision(rolloutHorizon);
+            if (profile) {
+                lap(profile->advance);
+            }
+        } else {
+            Command command = policy(g, rng);
+            if (profile) {
+                lap(profile->moveGen);
+            }
+            executeCommand(g, command);
+            if (profile) {
+                lap(profile->execute);
+                ++profile->commands;
+            }
+        }
+    }
+    if (profile) {
+        ++profile->rollouts;
+        profile->ticks += g.t_q2 - start;
+    }
+    return g.t_q2;
+}
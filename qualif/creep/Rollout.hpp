@@ -0,0 +1,62 @@
+#pragma once
+
+#include "creep2.hh"
+#include "Command.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <random>
+
+// rollouts stop at this tick or when the map is covered
+const int rolloutHorizon = 1000;
+
+// Counter based random streams: the stream of (key, index) only depends on
+// the master seed, so the rollouts come out the same whichever thread plays
+// them. The master seed is read from the CREEP_SEED environment variable,
+// or drawn and printed once when it isn't set.
+std::uint64_t masterSeed();
+std::minstd_rand rolloutRNG(std::uint64_t key, std::uint64_t index);
+
+// picks a move in a state where game::hasValidMove() holds
+using RolloutPolicy = std::function<Command(const game&, std::minstd_rand&)>;
+
+bool isRolloutOver(const game& g);
+
+// a random edge cell for the first available tumor, or failing that for
+// the first available queen
+Command randomRolloutMove(const game& g, std::minstd_rand& rng);
+
+// Weights of the cheap priors of an edge cell, all counted over the radius
+// 10 disc around it from the bitboards. Cells nothing reaches yet are what
+// matters; counting the cells without creep as well made the rollouts
+// worse, by 2-8 ticks on average at a weight of 0.5 on creep.map and
+// random maps, so there is no prior for them.
+struct RolloutPriors {
+    double fresh = 4; // cells no building reaches yet
+    double walls = 1; // walls and cells off the map, a penalty
+    double exponent = 2; // sharpens the distribution
+};
+
+// Same moves as randomRolloutMove, but the edge cell is drawn with weight
+// (1 + the priors) ^ exponent.
+RolloutPolicy weightedRolloutPolicy(RolloutPriors priors = RolloutPriors{});
+
+// where the time of the rollouts went, in seconds, summed over rollouts
+struct RolloutProfile {
+    long long rollouts = 0;
+    long long ticks = 0; // simulated
+    long long commands = 0;
+    double clone = 0;
+    double moveGen = 0; // in the policy, mostly edge cells
+    double execute = 0;
+    double advance = 0;
+    double busy = 0; // the whole rollout tasks
+
+    RolloutProfile& operator+=(const RolloutProfile& other);
+};
+
+// plays the policy, ticking whenever there is nothing to do, and returns
+// the final tick; the time of each step goes to the profile when there is
+// one
+int playOut(game& g, const RolloutPolicy& policy, std::minstd_rand& rng,
+    RolloutProfile* profile = nullptr);
@@ -0,0 +1,104 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount) {
+    for (int i = 0; i < std::max(1, threadCount); ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < size(); ++i) {
+        workers[i]->thread = std::thread([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+int ThreadPool::defaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run(int taskCount, const Body& body) {
+    if (taskCount <= 0) {
+        return;
+    }
+    // deal the tasks round robin, stealing evens out the rest
+    for (int i = 0; i < size(); ++i) {
+        std::lock_guard<std::mutex> lock(workers[i]->mutex);
+        for (int task = i; task < taskCount; task += size()) {
+            workers[i]->tasks.push_back(task);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    this->body = &body;
+    remaining = taskCount;
+    ++generation;
+    wake.notify_all();
+    done.wait(lock, [this]() { return remaining == 0 && active == 0; });
+    this->body = nullptr;
+}
+
+bool ThreadPool::popTask(int index, int& task) {
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (int i = 1; i < size(); ++i) {
+        Worker& victim = *workers[(index + i) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int index) {
+    std::uint64_t seen = 0;
+    while (true) {
+        const Body* current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            current = body;
+            ++active;
+        }
+
+        int task;
+        while (current && popTask(index, task)) {
+            (*current)(index, task);
+            --remaining;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --active;
+        }
+        done.notify_all();
+    }
+}
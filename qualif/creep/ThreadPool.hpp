@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads with one task deque each. A worker pops from
+// the back of its own deque and steals from the front of the others when it
+// runs dry, so uneven tasks don't leave cores idle.
+class ThreadPool {
+public:
+    using Body = std::function<void(int worker, int task)>;
+
+    explicit ThreadPool(int threadCount = defaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return workers.size(); }
+
+    // Calls body(worker, task) for every task in [0, taskCount) and returns
+    // when all of them are done. Not reentrant, one batch at a time.
+    void run(int taskCount, const Body& body);
+
+    static int defaultThreadCount();
+    static ThreadPool& instance();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<int> tasks;
+        std::thread thread;
+    };
+
+    void workerLoop(int index);
+    bool popTask(int index, int& task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const Body* body = nullptr;
+    std::uint64_t generation = 0;
+    int active = 0; // workers inside a batch
+    std::atomic<int> remaining{0};
+    bool stopping = false;
+};
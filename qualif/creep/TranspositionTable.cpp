@@ -0,0 +1,66 @@
+#include "TranspositionTable.hpp"
+
+#include <thread>
+
+TranspositionTable::TranspositionTable(int log2Buckets)
+    : mask((std::uint64_t(1) << log2Buckets) - 1)
+    , buckets(new Bucket[mask + 1])
+{}
+
+TranspositionTable& TranspositionTable::instance() {
+    static TranspositionTable table;
+    return table;
+}
+
+void TranspositionTable::Bucket::lock() const {
+    while (locked.exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void TranspositionTable::add(std::uint64_t key, int score) {
+    Bucket& bucket = bucketOf(key);
+    bucket.lock();
+    Entry* entry = nullptr;
+    for (auto& e : bucket.entries) {
+        if (e.stats.count > 0 && e.key == key) {
+            entry = &e;
+        }
+    }
+    if (!entry) {
+        entry = &bucket.entries[0];
+        if (bucket.entries[1].stats.count < entry->stats.count) {
+            entry = &bucket.entries[1];
+        }
+        entry->key = key;
+        entry->stats = Stats{};
+    }
+    ++entry->stats.count;
+    entry->stats.sum += score;
+    entry->stats.sumSq += (long long)score * score;
+    bucket.unlock();
+}
+
+bool TranspositionTable::find(std::uint64_t key, Stats& stats) const {
+    const Bucket& bucket = bucketOf(key);
+    bucket.lock();
+    bool found = false;
+    for (auto& e : bucket.entries) {
+        if (e.stats.count > 0 && e.key == key) {
+            stats = e.stats;
+            found = true;
+        }
+    }
+    bucket.unlock();
+    return found;
+}
+
+void TranspositionTable::clear() {
+    for (std::uint64_t i = 0; i <= mask; ++i) {
+        buckets[i].lock();
+        for (auto& e : buckets[i].entries) {
+            e = Entry{};
+        }
+        buckets[i].unlock();
+    }
+}
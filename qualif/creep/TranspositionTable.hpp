@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Rollout statistics by game::hash(), shared between searches and pool
+// workers. The scores only mean something for the rollout policy that
+// played them, so every policy needs a table of its own: instance() is
+// MCTS's, MonteCarlo::sharedTable() MC's. The size is fixed: every bucket holds two entries, and
+// a new key evicts the one with fewer samples. Buckets are guarded by
+// their own spinlock, so concurrent updates only contend on collisions.
+class TranspositionTable {
+public:
+    struct Stats {
+        int count = 0;
+        long long sum = 0;
+        long long sumSq = 0;
+    };
+
+    explicit TranspositionTable(int log2Buckets = 16);
+
+    void add(std::uint64_t key, int score);
+    // false if the key is not in the table
+    bool find(std::uint64_t key, Stats& stats) const;
+    void clear();
+
+    static TranspositionTable& instance();
+
+private:
+    struct Entry {
+        std::uint64_t key = 0;
+        Stats stats;
+    };
+    struct Bucket {
+        mutable std::atomic<bool> locked{false};
+        Entry entries[2];
+
+        void lock() const;
+        void unlock() const { locked.store(false, std::memory_order_release); }
+    };
+
+    Bucket& bucketOf(std::uint64_t key) const { return buckets[key & mask]; }
+
+    std::uint64_t mask;
+    std::unique_ptr<Bucket[]> buckets;
+};
@@ -1,109 +1,54 @@
 #include "creep2.hh"
+#include "CommandHistory.hpp"
+#include "gui/Game.hpp"
 #include "MC.hpp"
-
-void executeCommand(game& g, const Command& command) {
-    if (command.command <= 0) {
-        g.tick();
-    } else {
-        int cmd = command.command;
-        int id = command.id;
-        int x = command.x;
-        int y = command.y;
-        if (cmd == 1) {
-            g.queen_spawn_creep_tumor(g.get_queen(id),pos(x,y));
-        } else if (cmd == 2) {
-            g.creep_tumor_spawn_creep_tumor(g.get_creep_tumor(id),pos(x,y));
-        } else {
-            assert(0 && "invalid cmd code");
-        }
-    }
-}
-
-std::vector<Command> LoadCommands(const std::string& file) {
-    std::vector<Command> commands;
-    std::ifstream in(file);
-
-    int count;
-    in >> count;
-    int last_command = 0;
-    for (int i = 0; i < count; ++i) {
-        Command cmd;
-        in >> cmd.t >> cmd.command >> cmd.id >> cmd.x >> cmd.y;
-        for (int j = last_command; j < cmd.t; ++j) {
-            commands.push_back(Command{});
-            commands.back().t = j;
-            last_command = cmd.t;
-        }
-        commands.push_back(cmd);
-    }
-    return commands;
-}
+#include "MCTS.hpp"
 
 int main(int argc, char **argv) {
     assert(argc == 2 || argc == 3);
 
-    auto g = std::make_unique<game>(argv[1]);
-    std::vector<Command> commands;
-    std::vector<Command> redoCommands;
+    auto initial = std::make_unique<game>(argv[1]);
+    CommandHistory history(*initial);
 
     if (argc == 3) {
-        commands = LoadCommands(argv[2]);
-    }
-
-    for (auto& cmd : commands) {
-        assert(cmd.t == g->t_q2);
-        executeCommand(*g, cmd);
+        for (auto& cmd : LoadCommands(argv[2])) {
+            assert(cmd.t == history.state().t_q2);
+            history.execute(cmd);
+        }
     }
 
-    gui::Game gui(GuiModelFromGame(*g));
+    gui::Game gui(GuiModelFromGame(history.state()));
 
-    auto commandCallback = [&](const Command& copy) {
-        redoCommands.clear();
-        auto command = copy;
-        command.t = g->t_q2;
-        commands.push_back(command);
-        executeCommand(*g, command);
-        gui.setModel(GuiModelFromGame(*g));
+    auto commandCallback = [&](const Command& command) {
+        history.execute(command);
+        gui.setModel(GuiModelFromGame(history.state()));
     };
 
     gui.setCommandCallback(commandCallback);
     gui.setUndoCallback([&]() {
-        while (!commands.empty() && commands.back().command <= 0) {
-            redoCommands.push_back(commands.back());
-            commands.pop_back();
-        }
-        if (!commands.empty()) {
-            redoCommands.push_back(commands.back());
-            commands.pop_back();
-        }
-        g = std::make_unique<game>(argv[1]);
-        for (auto& command : commands) {
-            executeCommand(*g, command);
-        }
-        gui.setModel(GuiModelFromGame(*g));
+        history.undo();
+        gui.setModel(GuiModelFromGame(history.state()));
     });
     gui.setRedoCallback([&]() {
-        while (!redoCommands.empty() && redoCommands.back().command <= 0) {
-            commands.push_back(redoCommands.back());
-            executeCommand(*g, redoCommands.back());
-            redoCommands.pop_back();
-        }
-        if (!redoCommands.empty()) {
-            commands.push_back(redoCommands.back());
-            executeCommand(*g, redoCommands.back());
-            redoCommands.pop_back();
-        }
-        gui.setModel(GuiModelFromGame(*g));
+        history.redo();
+        gui.setModel(GuiModelFromGame(history.state()));
     });
+#ifdef USE_MCTS
+    MCTS mcts;
+#endif
     gui.setAutoCallback([&]() {
-        MonteCarlo mc(g.get());
+#ifdef USE_MCTS
+        auto cmd = mcts.decide(history.state(), MCTS_ITER);
+#else
+        MonteCarlo mc(&history.state());
         auto cmd = mc.getAutoMove();
+#endif
         commandCallback(cmd);
     });
     gui.run();
 
     std::vector<Command> final_commands;
-    for (auto& command : commands) {
+    for (auto& command : history.commands()) {
         if (command.command > 0) {
             final_commands.push_back(command);
         }
@@ -117,39 +62,41 @@ int main(int argc, char **argv) {
     return 0;
 }
 
-Model GuiModelFromGame(game& game) {
-    TileMatrix tiles(boost::extents[game.map_dx][game.map_dy]);
+Model GuiModelFromGame(const game& game) {
+    std::vector<Tile> tiles(game.map_dx * game.map_dy, Tile::Empty);
+    std::vector<CreepTumor> tumors;
 
     for (int y = 0; y < game.map_dy; ++y) {
         for (int x = 0; x < game.map_dx; ++x) {
-            auto* building = game.map_building[y][x];
-            if (game.map_wall[y][x]) {
-                tiles[x][y] = Wall{};
-            } else if (building) {
-                if (building->name() == std::string("creep_tumor")) {
-                    auto* ct = static_cast<creep_tumor*>(building);
-                    CreepTumor creepTumor;
-                    creepTumor.id = ct->id;
-                    if (!ct->spawn_creep_tumor_active) {
-                        creepTumor.state = CreepTumor::State::InActive;
-                    } else if (ct->dt_spawn_creep_tumor_cooldown_q8 > 0) {
-                        creepTumor.state = CreepTumor::State::Cooldown;
-                        creepTumor.cooldown =
-                            ct->dt_spawn_creep_tumor_cooldown_q8 / dt_tick_q8;
-                    } else {
-                        creepTumor.state = CreepTumor::State::Active;
-                    }
-                    tiles[x][y] = creepTumor;
+            int building = game.building_at(pos(x, y));
+            Tile& tile = tiles[y * game.map_dx + x];
+            if (game.wall_at(pos(x, y))) {
+                tile = Tile::Wall;
+            } else if (building > 0) {
+                int i = building - 1;
+                CreepTumor creepTumor;
+                creepTumor.position = {x, y};
+                creepTumor.id = game.tumor_id[i];
+                if (!game.tumor_active[i]) {
+                    creepTumor.state = CreepTumor::State::InActive;
+                } else if (game.tumor_cooldown_q8[i] > 0) {
+                    creepTumor.state = CreepTumor::State::Cooldown;
+                    creepTumor.cooldown =
+                        game.tumor_cooldown_q8[i] / dt_tick_q8;
                 } else {
-                    tiles[x][y] = Hatchery{};
+                    creepTumor.state = CreepTumor::State::Active;
                 }
-            } else if (game.map_creep[y][x]) {
-                tiles[x][y] = Creep{};
-            } else if (0 < game.map_creep_gen[y][x]) {
+                tumors.push_back(creepTumor);
+                tile = Tile::CreepTumor;
+            } else if (building == 0) {
+                tile = Tile::Hatchery;
+            } else if (game.creep_at(pos(x, y))) {
+                tile = Tile::Creep;
+            } else if (game.creep_gen_at(pos(x, y))) {
                 if (game.creep_spread_candidate(pos(x, y))) {
-                    tiles[x][y] = CreepCandidate{};
+                    tile = Tile::CreepCandidate;
                 } else {
-                    tiles[x][y] = CreepRadius{};
+                    tile = Tile::CreepRadius;
                 }
             }
         }
@@ -157,67 +104,22 @@ Model GuiModelFromGame(game& game) {
 
     std::vector<Queen> queens;
 
-    for (auto* unit : game.units) {
-        auto* q = static_cast<queen*>(unit);
+    for (int i = 0; i < game.queen_count; ++i) {
         Queen queen;
-        queen.id = q->id;
-        queen.energy = q->energy_q8;
+        queen.id = game.queen_id[i];
+        queen.energy = game.queen_energy_q8[i];
         queens.push_back(queen);
     }
 
     Model model {
         game.t_q2,
         game.t_limit_q2,
-        tiles,
-        queens
+        game.map_dx,
+        game.map_dy,
+        std::move(tiles),
+        std::move(tumors),
+        std::move(queens)
     };
     model.game = &game;
     return model;
 }
-
-std::vector<pos> GetQueenSpawnablePositions(game& game) {
-    std::vector<pos> result;
-    for(uint y = 0; y < game.map_dy; ++y) {
-        for(uint x = 0; x < game.map_dx; ++x) {
-            auto p = pos(x, y);
-            if (game.valid_pos(p) &&
-                !game.map_wall[p.y][p.x] &&
-                !game.map_building[p.y][p.x] &&
-                game.map_creep[p.y][p.x])
-            {
-                result.push_back(p);
-            }
-        }
-    }
-    return result;
-}
-
-Command GetCommand(game& game) {
-    for (auto* building : game.buildings) {
-        if (building->name() == std::string("creep_tumor")) {
-            auto ct = static_cast<creep_tumor*>(building);
-            if (!ct->spawn_creep_tumor_active) {
-                // inactive
-            } else if (ct->dt_spawn_creep_tumor_cooldown_q8 > 0) {
-                // cooldown
-            } else {
-                // available
-            }
-        }
-    }
-
-    for (auto* unit : game.units) {
-        if (unit->name() == std::string("queen")) {
-            auto q = static_cast<queen*>(unit);
-            if (q->energy_q8 < queen::spawn_creep_tumor_energy_cost_q8) {
-                // charging
-            } else {
-                auto spawnable_pos = GetQueenSpawnablePositions(game);
-                auto p = spawnable_pos[rand() % spawnable_pos.size()];
-
-                return Command::QueenSpawn(q->id, p.x, p.y);
-            }
-        }
-    }
-    return Command{};
-}
@@ -10,13 +10,20 @@
 #include <iomanip>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <type_traits>
 
-#include "gui/Game.hpp"
-#include "Model.hpp"
+#include "Command.hpp"
+#include "Disc.hpp"
 
 struct game;
-Command GetCommand(game& game);
-Model GuiModelFromGame(game& game);
+struct Model;
+// a random creep cell for the first queen with the energy for it
+Command GetCommand(const game& game, std::minstd_rand& rng);
+Model GuiModelFromGame(const game& game);
 
 // bal alsó sarok 0,0, jobbra x, felfelé y tengely
 int const map_max_dx=64;
@@ -115,174 +122,130 @@ struct bound_rect
     int x0,y0,x1,y1;
 };
 
-struct game;
-struct object;
-struct building;
-struct hatchery;
-struct creep_tumor;
-struct unit;
-struct queen;
-
-struct object
-{
-    object():
-        id(0), br(),
-        max_health_q8(0), health_q8(0),
-        max_energy_q8(0), energy_q8(0),
-        creep_spread_radius(0)
-    {}
-    virtual ~object() {}
-    virtual void tick()
-    {
-        health_q8=std::min(max_health_q8,
-            health_q8+health_regeneration_q8*dt_tick_q8/256);
-        energy_q8=std::min(max_energy_q8,
-            energy_q8+energy_regeneration_q8*dt_tick_q8/256);
-    }
-    virtual char const *name() const =0;
-    virtual char const *map_cell_code() const { return "?"; }
-    virtual void dump_available_abilities(std::ostream &o) const {}
-
-    virtual object* clone() = 0;
-
-    int id;
-    bound_rect br;
-    int max_health_q8;
-    int health_q8;
-    int max_energy_q8;
-    int energy_q8;
-    int creep_spread_radius;
-};
-
-struct building: public object
-{
-    building(pos const &p0, int dx, int dy, int max_health)
-    {
-        br.x0=p0.x;
-        br.y0=p0.y;
-        br.x1=br.x0+dx;
-        br.y1=br.y0+dy;
-        max_health_q8=max_health*256;
-        health_q8=max_health_q8;
-    }
-
-    virtual building* clone() = 0;
-
-    virtual ~building() {}
-    virtual creep_tumor& a_creep_tumor_i_suppose() { assert(0 && "not a creep tumor"); }
-};
-
-struct hatchery: public building
+int const hatchery_size=3;
+int const creep_spread_radius=10;
+int const spawn_creep_tumor_radius=10;
+int const dt_spawn_creep_tumor_cooldown_q8=15.0*256;
+int const queen_max_energy_q8=200.0*256;
+int const queen_start_energy_q8=25.0*256;
+int const dt_queen_build_time_q8=int(60.0*256);
+int const spawn_creep_tumor_energy_cost_q8=int(25.0*256);
+
+int const max_t_limit_q2=100000;
+// Spawning a tumor past max_creep_tumors is a spawn error, creep.cc has no
+// such limit. Queens come one per build time until the time limit, so
+// max_queens holds all of them on any map.
+int const max_creep_tumors=256;
+int const max_queens=max_t_limit_q2*dt_tick_q8/dt_queen_build_time_q8+1;
+
+// one map row, bit x is column x
+typedef std::uint64_t row_bits;
+static_assert(map_max_dx<=64, "a map row must fit in row_bits");
+
+inline int bit_count(row_bits r) { return __builtin_popcountll(r); }
+inline bool bit_at(row_bits r, int x) { return r>>x&1; }
+inline row_bits bit_of(int x) { return row_bits(1)<<x; }
+
+// Zobrist keys, hashed from (kind, a, b) on the fly instead of tabled
+inline std::uint64_t zobrist_key(int kind, int a, int b=0)
 {
-    hatchery(pos const &p0): building(p0,3,3,1500)
-    {
-        creep_spread_radius=10;
-    }
-
-    virtual hatchery* clone() override { return new hatchery(*this); }
-
-    virtual ~hatchery() {}
-    virtual char const *name() const override { return "hatchery"; }
-    virtual char const *map_cell_code() const override { return print_hatchery; }
-};
-
-struct creep_tumor: public building
+    std::uint64_t x=(std::uint64_t(kind)<<48)^(std::uint64_t(a)<<24)
+        ^std::uint32_t(b);
+    // splitmix64
+    x+=0x9e3779b97f4a7c15ULL;
+    x=(x^(x>>30))*0xbf58476d1ce4e5b9ULL;
+    x=(x^(x>>27))*0x94d049bb133111ebULL;
+    return x^(x>>31);
+}
+enum zobrist_kind { zk_wall=1, zk_creep, zk_tumor, zk_queen, zk_tick, zk_base };
+inline int zobrist_cell(int x, int y) { return y*map_max_dx+x; }
+
+// The cells of a creep_spread_radius disc around a cell center, row i is
+// dy=i-(creep_spread_radius-1), bit j is dx=j-(creep_spread_radius-1).
+int const creep_disc_size=2*creep_spread_radius-1;
+static_assert(creep_spread_radius<=disc_max_radius
+    && spawn_creep_tumor_radius<=disc_max_radius, "radius not in the disc tables");
+struct creep_disc
 {
-    creep_tumor(pos const &p0): building(p0,1,1,200)
+    row_bits row[creep_disc_size];
+    constexpr creep_disc(): row()
     {
-        creep_spread_radius=10;
-        spawn_creep_tumor_active=1;
-        dt_spawn_creep_tumor_cooldown_q8=15.0*256;
-    }
-
-    virtual creep_tumor* clone() override { return new creep_tumor(*this); }
-
-    virtual ~creep_tumor() {}
-    virtual void tick() override
-    {
-        building::tick();
-        dt_spawn_creep_tumor_cooldown_q8=
-            std::max(0,dt_spawn_creep_tumor_cooldown_q8-dt_tick_q8);
+        int r=creep_spread_radius;
+        for(int dy=-r+1; dy<r; ++dy)
+        {
+            int w=disc_span(r,dy);
+            for(int dx=-w; dx<=w; ++dx)
+                row[dy+r-1]|=row_bits(1)<<(dx+r-1);
+        }
     }
-    virtual char const *name() const override { return "creep_tumor"; }
-    virtual char const *map_cell_code() const override
+    static creep_disc const &get()
     {
-        if(spawn_creep_tumor_active)
-            return dt_spawn_creep_tumor_cooldown_q8?print_creep_tumor_cooldown:print_creep_tumor_active;
-        else return print_creep_tumor_inactive;
+        static constexpr creep_disc disc{};
+        return disc;
     }
-    virtual void dump_available_abilities(std::ostream &o) const override
+    // row i of the disc centered on column x0
+    row_bits at(int i, int x0) const
     {
-        if(!spawn_creep_tumor_active)
-            o << ",inactive";
-        else if(0<dt_spawn_creep_tumor_cooldown_q8)
-            o << "," << color_yellow << "on_cooldown,dt=("
-                << dt_spawn_creep_tumor_cooldown_q8
-                << "," << std::fixed << std::setprecision(2)
-                << dt_spawn_creep_tumor_cooldown_q8/256.0 << ")"
-                << color_default;
-        else o << "," << color_green << "available" << color_default;
+        int s=x0-(creep_spread_radius-1);
+        return s<0 ? row[i]>>-s : row[i]<<s;
     }
-    virtual creep_tumor& a_creep_tumor_i_suppose() override { return *this; }
-
-    int spawn_creep_tumor_active;
-    int dt_spawn_creep_tumor_cooldown_q8;
-    static int const spawn_creep_tumor_radius=10;
 };
 
-struct unit: public object
+// The whole state of a game without pointers, one array per field, so
+// cloning it is a single memcpy of about 11 KB, mostly the tumor and queen
+// arrays sized for the limits.
+//
+// Buildings are indexed as 0: the hatchery, 1+i: the i-th creep tumor in
+// creation order. The cells of the buildings are map_blocked & ~map_wall,
+// building_at finds which one covers a cell.
+// Health is not stored, nothing deals damage here so it is always max.
+//
+// The cell flags are bitboards, one row_bits per map row, so the creep
+// frontier of a whole row is a handful of shifts and ORs.
+struct game_state
 {
-    unit(int max_health)
-    {
-        max_health_q8=max_health*256;
-        health_q8=max_health_q8;
-    }
-
-    virtual unit* clone() = 0;
-
-    virtual ~unit() {}
-    virtual queen& a_queen_i_suppose() { assert(0 && "not a queen"); }
+    int next_id;
+    int t_q2;
+    int t_limit_q2;
+    pos p_base;
+    int map_dx,map_dy;
+    int creep_cover;
+    // Zobrist hash of the walls, the base and the creep cells
+    std::uint64_t map_hash;
+
+    int hatchery_id;
+
+    int tumor_count;
+    int tumor_id[max_creep_tumors];
+    pos tumor_pos[max_creep_tumors];
+    int tumor_active[max_creep_tumors];
+    int tumor_cooldown_q8[max_creep_tumors];
+
+    int queen_count;
+    int queen_id[max_queens];
+    int queen_energy_q8[max_queens];
+
+    row_bits map_creep_gen[map_max_dy]; // in the spread radius of a building
+    row_bits map_creep[map_max_dy];
+    row_bits map_wall[map_max_dy];
+    row_bits map_blocked[map_max_dy]; // wall or building
+    row_bits map_frontier[map_max_dy]; // see creep_frontier
 };
 
-struct queen: public unit
-{
-    queen(): unit(175)
-    {
-        max_energy_q8=200.0*256;
-        energy_q8=25.0*256;
-    }
-
-    virtual queen* clone() override { return new queen(*this); }
-
-    virtual ~queen() {}
-    virtual char const *name() const override { return "queen"; }
-    virtual void dump_available_abilities(std::ostream &o) const override
-    {
-        o << ",";
-        if(energy_q8<queen::spawn_creep_tumor_energy_cost_q8)
-            o << color_yellow << "needs_25_energy" << color_default;
-        else o << color_green << "available" << color_default;
-    }
-    virtual queen& a_queen_i_suppose() override { return *this; }
-
-    static int const dt_build_time_q8=int(60.0*256);
-    static int const spawn_creep_tumor_energy_cost_q8=int(25.0*256);
-};
+static_assert(std::is_trivially_copyable<game_state>::value,
+    "game_state is cloned with memcpy");
 
-struct game
+// The simulation rules on top of game_state, no data of its own.
+struct game: game_state
 {
     game() = default;
-    game(char const *map_file_name):
-        next_id(0), t_q2(0), t_limit_q2(0), p_base(),
-        buildings(), units(),
-        map_dx(), map_dy(),
-        map_creep_gen(), map_creep(), creep_cover(0),
-        map_wall(), map_building()
+    game(char const *map_file_name)
     {
+        static_cast<game_state&>(*this)=game_state{};
         FILE *f=fopen(map_file_name,"rt");
         assert(f && "can't open map file");
         bool ok=fscanf(f,"%d",&t_limit_q2)==1
-            && 10<=t_limit_q2 && t_limit_q2<=100000;
+            && 10<=t_limit_q2 && t_limit_q2<=max_t_limit_q2;
         assert(ok && "map time limit");
         ok=fscanf(f,"%d%d",&map_dx,&map_dy)==2
             && 16<=map_dx && map_dx<=map_max_dx
@@ -297,7 +260,11 @@ struct game
             for(int x=0; ok && x<map_dx; ++x)
             {
                 if(s[x]=='#')
-                    map_wall[y][x]=1;
+                {
+                    map_wall[y]|=bit_of(x);
+                    map_blocked[y]|=bit_of(x);
+                    map_hash^=zobrist_key(zk_wall,zobrist_cell(x,y));
+                }
                 else
                 {
                     ok=s[x]=='.';
@@ -306,9 +273,9 @@ struct game
             }
         }
         for(uint y=0; ok && y<map_dy; ++y)
-            ok=map_wall[y][0] && map_wall[y][map_dx-1];
+            ok=bit_at(map_wall[y],0) && bit_at(map_wall[y],map_dx-1);
         for(uint x=0; ok && x<map_dx; ++x)
-            ok=map_wall[0][x] && map_wall[map_dy-1][x];
+            ok=bit_at(map_wall[0],x) && bit_at(map_wall[map_dy-1],x);
         assert(ok && "map file format");
 
         ok=fscanf(f,"%d%d",&p_base.x,&p_base.y)==2
@@ -316,6 +283,7 @@ struct game
             && 0<=p_base.y && p_base.y+5<=map_dy;
         assert(ok && "map hatch position");
         fclose(f);
+        map_hash^=zobrist_key(zk_base,zobrist_cell(p_base.x,p_base.y));
 
         {
             bool v[map_max_dy][map_max_dx]={};
@@ -325,7 +293,7 @@ struct game
             {
                 pos p=q.back();
                 q.pop_back();
-                if(map_wall[p.y][p.x] || v[p.y][p.x])
+                if(wall_at(p) || v[p.y][p.x])
                     continue;
                 v[p.y][p.x]=1;
                 ++n;
@@ -335,101 +303,167 @@ struct game
             assert(n==ne && "connected space plz");
         }
 
-        add_building(new hatchery(p_base)); // id=1
-        add_unit(new queen()); // id=2
+        add_hatchery(); // id=1
+        add_queen(); // id=2
         all_creep_now_plz();
     }
-    ~game()
-    {
-        for(auto p: units)
-            delete p;
-        for(auto p: buildings)
-            delete p;
-    }
     bool valid_pos(pos const &p) const
     {
         return 0<=p.x && p.x<map_dx && 0<=p.y && p.y<map_dy;
     }
+    bool wall_at(pos const &p) const { return bit_at(map_wall[p.y],p.x); }
+    bool creep_at(pos const &p) const { return bit_at(map_creep[p.y],p.x); }
+    bool creep_gen_at(pos const &p) const { return bit_at(map_creep_gen[p.y],p.x); }
+    bool building_on(pos const &p) const
+    {
+        return bit_at(map_blocked[p.y]&~map_wall[p.y],p.x);
+    }
+    row_bits row_mask() const
+    {
+        return map_dx==64 ? ~row_bits(0) : bit_of(map_dx)-1;
+    }
+    int building_count() const { return 1+tumor_count; }
+    // bottom left corner and size of building b
+    pos building_pos(int b) const { return b==0?p_base:tumor_pos[b-1]; }
+    int building_size(int b) const { return b==0?hatchery_size:1; }
+    int building_id(int b) const { return b==0?hatchery_id:tumor_id[b-1]; }
+    // the building covering p, -1 if none
+    int building_at(pos const &p) const
+    {
+        if(!building_on(p))
+            return -1;
+        for(int b=0; b<building_count(); ++b)
+        {
+            pos q=building_pos(b);
+            int d=building_size(b);
+            if(q.x<=p.x && p.x<q.x+d && q.y<=p.y && p.y<q.y+d)
+                return b;
+        }
+        assert(false && "a building cell without a building");
+        return -1;
+    }
+    // every building spreads creep around its center
+    pos building_center(int b) const
+    {
+        pos p=building_pos(b);
+        int d=building_size(b);
+        return pos((2*p.x+d)/2,(2*p.y+d)/2);
+    }
     // p0 pozíciójú cella közepe köré rajzolt radius sugarú körön belüli cellák
+    // one span per row, see Disc.hpp
     void valid_cells_in_a_radius(std::vector<pos> &cells,
         pos const &p0, int radius) const
     {
         for(int dy=-radius+1; dy<radius; ++dy)
-            for(int dx=-radius+1; dx<radius; ++dx)
-            {
-                pos p(p0.x+dx,p0.y+dy);
-                if(!valid_pos(p))
-                    continue;
-                int dx_q1=2*dx+(0<dx?1:-1);
-                int dy_q1=2*dy+(0<dy?1:-1);
-                int d2_q2=dx_q1*dx_q1+dy_q1*dy_q1;
-                if(d2_q2<=radius*radius*4)
-                    cells.push_back(p);
-            }
+        {
+            int y=p0.y+dy;
+            if(y<0 || map_dy<=y)
+                continue;
+            int w=disc_span(radius,dy);
+            int x1=std::min(map_dx-1,p0.x+w);
+            for(int x=std::max(0,p0.x-w); x<=x1; ++x)
+                cells.push_back(pos(x,y));
+        }
     }
     // ha ez a cella szabad és nincs rajta creep,
     // a szomszédban valahol van creep, akkor ide terjeszkedhet
     // előfeltétel hogy a cella egy generátor területén belül legyen
-    bool creep_spread_candidate(pos const &p) const
+    row_bits creep_frontier(int y) const
     {
-        return !map_wall[p.y][p.x] && !map_building[p.y][p.x]
-            && !map_creep[p.y][p.x]
-            && ((0<p.x && map_creep[p.y][p.x-1])
-                || (p.x+1<map_dx && map_creep[p.y][p.x+1])
-                || (0<p.y && map_creep[p.y-1][p.x])
-                || (p.y+1<map_dy && map_creep[p.y+1][p.x]));
+        return map_frontier[y];
     }
-    bool creep_spread_candidates(std::vector<pos> &candidates,
-        std::vector<pos> const &cells) const
+    // A cell only enters or leaves the frontier when it or a neighbor gets
+    // creep or a building, so after a change in rows y0..y1 only the rows
+    // y0-1..y1+1 are recomputed. The frontier of a building is this masked
+    // with its disc, in the same row major order as before.
+    void update_frontier(int y0, int y1)
     {
-        for(auto p: cells)
-            if(creep_spread_candidate(p))
-                candidates.push_back(p);
-        return !candidates.empty();
+        for(int y=std::max(0,y0-1); y<=y1+1 && y<map_dy; ++y)
+            map_frontier[y]=compute_frontier(y);
     }
-    bool creep_cells(std::vector<pos> &cells, object const &o) const
+    row_bits compute_frontier(int y) const
     {
-        if(0<o.creep_spread_radius)
+        row_bits c=map_creep[y];
+        row_bits n=c<<1 | c>>1;
+        if(0<y)
+            n|=map_creep[y-1];
+        if(y+1<map_dy)
+            n|=map_creep[y+1];
+        return n & ~c & ~map_blocked[y] & row_mask();
+    }
+    bool creep_spread_candidate(pos const &p) const
+    {
+        return bit_at(creep_frontier(p.y),p.x);
+    }
+    // the cells building b may spread creep to, wave[i] is map row
+    // center.y-(creep_spread_radius-1)+i; returns their count
+    int creep_wave(int b, row_bits *wave) const
+    {
+        creep_disc const &disc=creep_disc::get();
+        pos c=building_center(b);
+        int n=0;
+        for(int i=0; i<creep_disc_size; ++i)
         {
-            pos p0((o.br.x0+o.br.x1)/2,(o.br.y0+o.br.y1)/2);
-            valid_cells_in_a_radius(cells,p0,o.creep_spread_radius);
-            return true;
+            int y=c.y-(creep_spread_radius-1)+i;
+            wave[i]=0<=y && y<map_dy ? creep_frontier(y) & disc.at(i,c.x) : 0;
+            n+=bit_count(wave[i]);
         }
-        return false;
+        return n;
     }
-    void spread_creep()
+    // the k-th cell of the wave in row major order, as valid_cells_in_a_radius
+    // would list them; returns whether any creep spread
+    bool spread_creep()
     {
-        for(auto pb: buildings)
+        bool spread=0;
+        for(int b=0; b<building_count(); ++b)
         {
-            building const &b=*pb;
-            std::vector<pos> all;
-            std::vector<pos> wave;
-            if(creep_cells(all,b) && creep_spread_candidates(wave,all))
+            row_bits wave[creep_disc_size];
+            int n=creep_wave(b,wave);
+            if(n)
             {
-                uint k=(t_q2*t_q2+37)%wave.size();
-                pos nc=wave[k];
-                map_creep[nc.y][nc.x]=1;
+                uint k=(t_q2*t_q2+37)%std::size_t(n);
+                int i=0;
+                while(int(k)>=bit_count(wave[i]))
+                    k-=bit_count(wave[i++]);
+                row_bits w=wave[i];
+                for(; k; --k)
+                    w&=w-1;
+                int y=building_center(b).y-(creep_spread_radius-1)+i;
+                map_creep[y]|=w&-w;
+                map_hash^=zobrist_key(zk_creep,zobrist_cell(__builtin_ctzll(w),y));
                 ++creep_cover;
+                update_frontier(y,y);
+                spread=1;
             }
         }
+        return spread;
     }
     bool anything_to_do() const
     {
         for(int y=0; y<map_dy; ++y)
-            for(int x=0; x<map_dx; ++x)
-                if(map_creep_gen[y][x] && creep_spread_candidate(pos(x,y)))
-                    return true;
+            if(creep_frontier(y) & map_creep_gen[y])
+                return true;
         return false;
     }
+    // Nothing can change any more: creep has nowhere to spread, and no free
+    // cell borders it for a new tumor to reach. The cells left free are
+    // pockets shut in by buildings.
+    bool creep_finished() const
+    {
+        if(anything_to_do())
+            return false;
+        for(int y=0; y<map_dy; ++y)
+            if(creep_frontier(y))
+                return false;
+        return true;
+    }
+    // any free cell left inside the border
     bool has_empty() const {
-        for(int y = map_dy-2; y >= 1; --y) {
-            for(int x = map_dx - 2; x >= 1; --x) {
-                if (!map_wall[y][x] && !map_building[y][x] && !map_creep[y][x]) {
-                    return true;
-                }
-            }
-        }
-        return false;
+        row_bits inner=row_mask() & ~bit_of(0) & ~bit_of(map_dx-1);
+        int n=0;
+        for(int y = 1; y < map_dy-1; ++y)
+            n+=bit_count(~map_blocked[y] & ~map_creep[y] & inner);
+        return n!=0;
     }
     void all_creep_now_plz()
     {
@@ -437,121 +471,275 @@ struct game
         do
         {
             go=0;
-            for(auto pb: buildings)
+            for(int b=0; b<building_count(); ++b)
             {
-                building const &b=*pb;
-                std::vector<pos> all;
-                std::vector<pos> wave;
-                if(creep_cells(all,b) && creep_spread_candidates(wave,all))
-                    for(auto p: wave)
+                row_bits wave[creep_disc_size];
+                int n=creep_wave(b,wave);
+                if(n)
+                {
+                    int y0=building_center(b).y-(creep_spread_radius-1);
+                    for(int i=0; i<creep_disc_size; ++i)
                     {
-                        map_creep[p.y][p.x]=1;
-                        ++creep_cover;
-                        go=1;
+                        if(wave[i])
+                            map_creep[y0+i]|=wave[i];
+                        for(row_bits w=wave[i]; w; w&=w-1)
+                            map_hash^=zobrist_key(zk_creep,
+                                zobrist_cell(__builtin_ctzll(w),y0+i));
                     }
+                    update_frontier(y0,y0+creep_disc_size-1);
+                    creep_cover+=n;
+                    go=1;
+                }
             }
         }
         while(go);
     }
+    // Counts the tumor cooldowns down and regenerates the queen energies by
+    // n ticks. Both are straight min/max passes over the int arrays with no
+    // branches, so they vectorize; inactive tumors are counted down too,
+    // nothing reads their cooldown. The energy is regenerated in whole
+    // per tick steps, the same as n tick() calls.
+    void age_units(int n)
+    {
+        int const cooldown=n*dt_tick_q8;
+        int const energy=n*(energy_regeneration_q8*dt_tick_q8/256);
+        // the counts are copied, the stores could alias them otherwise
+        int const tumors=tumor_count;
+        int* cd=tumor_cooldown_q8;
+        for(int i=0; i<tumors; ++i)
+            cd[i]=std::max(0,cd[i]-cooldown);
+        int const queens=queen_count;
+        int* e=queen_energy_q8;
+        for(int i=0; i<queens; ++i)
+            e[i]=std::min(queen_max_energy_q8,e[i]+energy);
+    }
     void tick()
     {
         spread_creep();
-        for(auto p: buildings)
-            (*p).tick();
-        for(auto p: units)
-            (*p).tick();
+        age_units(1);
         ++t_q2;
-        if(t_q2*dt_tick_q8%queen::dt_build_time_q8==0)
-            add_unit(new queen());
+        if(t_q2*dt_tick_q8%dt_queen_build_time_q8==0)
+            add_queen();
+    }
+    // ticks until hasValidMove() holds: a tumor cooldown runs out, a queen
+    // regenerates enough energy or a new queen is built
+    int ticks_to_next_decision() const
+    {
+        if(hasValidMove())
+            return 0;
+        int const queen_period=dt_queen_build_time_q8/dt_tick_q8;
+        int const energy_per_tick=energy_regeneration_q8*dt_tick_q8/256;
+        int n=queen_period-t_q2%queen_period;
+        if(tumor_count==max_creep_tumors)
+            return n;
+        for(int i=0; i<tumor_count; ++i)
+            if(tumor_active[i])
+                n=std::min(n,(tumor_cooldown_q8[i]+dt_tick_q8-1)/dt_tick_q8);
+        for(int i=0; i<queen_count; ++i)
+            n=std::min(n,(spawn_creep_tumor_energy_cost_q8-queen_energy_q8[i]
+                +energy_per_tick-1)/energy_per_tick);
+        return n;
+    }
+    // The same as calling tick() until the next decision, t_stop or the
+    // map being covered, whichever comes first. Creep still spreads tick by
+    // tick since the cell picked depends on t_q2, but cooldowns and energies
+    // are updated once, and once a tick spreads nothing the rest is skipped:
+    // nothing else changes before the next decision.
+    void advance_until_next_decision(int t_stop)
+    {
+        int n=std::min(ticks_to_next_decision(),t_stop-t_q2);
+        if(n<=0)
+            return;
+        int const queen_period=dt_queen_build_time_q8/dt_tick_q8;
+        static_assert(dt_queen_build_time_q8%dt_tick_q8==0,
+            "queens are built on tick boundaries");
+        int done=0;
+        while(done<n && has_empty())
+        {
+            bool spread=spread_creep();
+            ++t_q2;
+            ++done;
+            if(!spread)
+            {
+                t_q2+=n-done;
+                done=n;
+            }
+        }
+        age_units(done);
+        if(done && t_q2%queen_period==0)
+            add_queen();
     }
-    void add_building(building *p)
+    void add_building(int b)
     {
-        buildings.push_back(p);
-        building &b=*p;
-        b.id=++next_id;
-        for(int y=b.br.y0; y<b.br.y1; ++y)
-            for(int x=b.br.x0; x<b.br.x1; ++x)
+        pos p=building_pos(b);
+        int d=building_size(b);
+        for(int y=p.y; y<p.y+d; ++y)
+            for(int x=p.x; x<p.x+d; ++x)
             {
-                assert(!map_building[y][x] && "a building there");
-                assert(!map_wall[y][x] && "a wall there");
-                map_building[y][x]=p;
-                if(0<b.creep_spread_radius && !map_creep[y][x])
+                assert(!bit_at(map_blocked[y],x) && "a wall or a building there");
+                map_blocked[y]|=bit_of(x);
+                if(!bit_at(map_creep[y],x))
                 {
-                    map_creep[y][x]=1;
+                    map_creep[y]|=bit_of(x);
+                    map_hash^=zobrist_key(zk_creep,zobrist_cell(x,y));
                     ++creep_cover;
                 }
             }
-        std::vector<pos> cells;
-        if(creep_cells(cells,b))
-            for(auto p: cells)
-                ++map_creep_gen[p.y][p.x];
+        update_frontier(p.y,p.y+d-1);
+        creep_disc const &disc=creep_disc::get();
+        pos c=building_center(b);
+        for(int i=0; i<creep_disc_size; ++i)
+        {
+            int y=c.y-(creep_spread_radius-1)+i;
+            if(0<=y && y<map_dy)
+                map_creep_gen[y]|=disc.at(i,c.x) & row_mask();
+        }
     }
-    void add_unit(unit *p)
+    void add_hatchery()
     {
-        units.push_back(p);
-        unit &u=*p;
-        u.id=++next_id;
+        hatchery_id=++next_id;
+        add_building(0);
     }
-    queen& get_queen(int id)
+    void add_creep_tumor(pos const &p)
+    {
+        assert(tumor_count<max_creep_tumors && "too many creep tumors");
+        int i=tumor_count++;
+        tumor_id[i]=++next_id;
+        tumor_pos[i]=p;
+        tumor_active[i]=1;
+        tumor_cooldown_q8[i]=dt_spawn_creep_tumor_cooldown_q8;
+        add_building(1+i);
+    }
+    void add_queen()
+    {
+        assert(queen_count<max_queens && "too many queens");
+        if(queen_count==max_queens)
+            return;
+        int i=queen_count++;
+        queen_id[i]=++next_id;
+        queen_energy_q8[i]=queen_start_energy_q8;
+    }
+    // index of the queen with the given id
+    int get_queen(int id) const
     {
-        for(auto p: units)
-            if((*p).id==id)
-                return (*p).a_queen_i_suppose();
+        for(int i=0; i<queen_count; ++i)
+            if(queen_id[i]==id)
+                return i;
         assert(0 && "invalid id");
+        return -1;
     }
-    creep_tumor& get_creep_tumor(int id)
+    // index of the creep tumor with the given id
+    int get_creep_tumor(int id) const
     {
-        for(auto p: buildings)
-            if((*p).id==id)
-                return (*p).a_creep_tumor_i_suppose();
-        assert(0 && "invalid id");
+        for(int i=0; i<tumor_count; ++i)
+            if(tumor_id[i]==id)
+                return i;
+        assert(0 && (id==hatchery_id ? "not a creep tumor" : "invalid id"));
+        return -1;
+    }
+    // get_queen and get_creep_tumor without the assert, -1 if not found
+    int find_queen(int id) const
+    {
+        for(int i=0; i<queen_count; ++i)
+            if(queen_id[i]==id)
+                return i;
+        return -1;
+    }
+    int find_creep_tumor(int id) const
+    {
+        for(int i=0; i<tumor_count; ++i)
+            if(tumor_id[i]==id)
+                return i;
+        return -1;
     }
-    void queen_spawn_creep_tumor(queen &u, pos const &p)
-    {
-        assert(queen::spawn_creep_tumor_energy_cost_q8<=u.energy_q8 && "not enough energy");
-        assert(valid_pos(p) && !map_wall[p.y][p.x] && !map_building[p.y][p.x]
-            && map_creep[p.y][p.x] && "not on creep");
-        u.energy_q8-=queen::spawn_creep_tumor_energy_cost_q8;
-        add_building(new creep_tumor(p));
-    }
-    void creep_tumor_spawn_creep_tumor(creep_tumor &b, pos const &p)
-    {
-        assert(b.spawn_creep_tumor_active==1 && "creep tumor not active");
-        assert(b.dt_spawn_creep_tumor_cooldown_q8==0 && "spawn creep tumor cooldown");
-        assert(valid_pos(p) && !map_wall[p.y][p.x] && !map_building[p.y][p.x]
-            && map_creep[p.y][p.x] && "not on creep");
-        std::vector<pos> cells;
-        pos p0(b.br.x0,b.br.y0);
-        valid_cells_in_a_radius(cells,p0,creep_tumor::spawn_creep_tumor_radius);
-        bool ok=0;
-        for(uint i=0; !ok && i<cells.size(); ++i)
-            ok=cells[i]==p;
-        assert(ok && "target too far");
-        b.spawn_creep_tumor_active=0;
-        add_building(new creep_tumor(p));
+    // what the spawn commands would assert on, nullptr if they are valid
+    char const *queen_spawn_error(int q, pos const &p) const
+    {
+        if(queen_energy_q8[q]<spawn_creep_tumor_energy_cost_q8)
+            return "not enough energy";
+        if(tumor_count==max_creep_tumors)
+            return "too many creep tumors";
+        if(!valid_pos(p) || wall_at(p) || building_on(p) || !creep_at(p))
+            return "not on creep";
+        return nullptr;
+    }
+    char const *creep_tumor_spawn_error(int t, pos const &p) const
+    {
+        if(tumor_active[t]!=1)
+            return "creep tumor not active";
+        if(tumor_cooldown_q8[t]!=0)
+            return "spawn creep tumor cooldown";
+        if(tumor_count==max_creep_tumors)
+            return "too many creep tumors";
+        if(!valid_pos(p) || wall_at(p) || building_on(p) || !creep_at(p))
+            return "not on creep";
+        if(!in_disc(p.x-tumor_pos[t].x,p.y-tumor_pos[t].y,spawn_creep_tumor_radius))
+            return "target too far";
+        return nullptr;
+    }
+    void queen_spawn_creep_tumor(int q, pos const &p)
+    {
+        assert(spawn_creep_tumor_energy_cost_q8<=queen_energy_q8[q] && "not enough energy");
+        assert(valid_pos(p) && !wall_at(p) && !building_on(p)
+            && creep_at(p) && "not on creep");
+        // past the limit the command does nothing, see queen_spawn_error
+        if(tumor_count==max_creep_tumors)
+            return;
+        queen_energy_q8[q]-=spawn_creep_tumor_energy_cost_q8;
+        add_creep_tumor(p);
+    }
+    void creep_tumor_spawn_creep_tumor(int t, pos const &p)
+    {
+        assert(tumor_active[t]==1 && "creep tumor not active");
+        assert(tumor_cooldown_q8[t]==0 && "spawn creep tumor cooldown");
+        assert(valid_pos(p) && !wall_at(p) && !building_on(p)
+            && creep_at(p) && "not on creep");
+        assert(in_disc(p.x-tumor_pos[t].x,p.y-tumor_pos[t].y,spawn_creep_tumor_radius)
+            && "target too far");
+        if(tumor_count==max_creep_tumors)
+            return;
+        tumor_active[t]=0;
+        add_creep_tumor(p);
+    }
+    char const *tumor_cell_code(int t) const
+    {
+        if(tumor_active[t])
+            return tumor_cooldown_q8[t]?print_creep_tumor_cooldown:print_creep_tumor_active;
+        else return print_creep_tumor_inactive;
     }
     friend std::ostream &operator<< (std::ostream &o, game const &g)
     {
         o << "t=(" << g.t_q2
             << "," << std::fixed << std::setprecision(2) << g.t_q2/4.0 << ")\n";
-        o << "buildings[" << g.buildings.size() << "]=\n";
-        for(auto p: g.buildings)
+        o << "buildings[" << g.building_count() << "]=\n";
+        o << "id=" << g.hatchery_id << ",hatchery"
+            << ",p=(" << g.p_base.x << "," << g.p_base.y << ")";
+        o << "\n";
+        for(int i=0; i<g.tumor_count; ++i)
         {
-            building const &b=*p;
-            o << "id=" << b.id << "," << b.name()
-                << ",p=(" << b.br.x0 << "," << b.br.y0 << ")";
-            b.dump_available_abilities(o);
+            o << "id=" << g.tumor_id[i] << ",creep_tumor"
+                << ",p=(" << g.tumor_pos[i].x << "," << g.tumor_pos[i].y << ")";
+            if(!g.tumor_active[i])
+                o << ",inactive";
+            else if(0<g.tumor_cooldown_q8[i])
+                o << "," << color_yellow << "on_cooldown,dt=("
+                    << g.tumor_cooldown_q8[i]
+                    << "," << std::fixed << std::setprecision(2)
+                    << g.tumor_cooldown_q8[i]/256.0 << ")"
+                    << color_default;
+            else o << "," << color_green << "available" << color_default;
             o << "\n";
         }
-        o << "units[" << g.units.size() << "]=\n";
-        for(auto p: g.units)
+        o << "units[" << g.queen_count << "]=\n";
+        for(int i=0; i<g.queen_count; ++i)
         {
-            unit const &u=*p;
-            o << "id=" << u.id << "," << u.name();
-            if(0<u.max_energy_q8)
-                o << ",energy=(" << u.energy_q8
-                    << "," << std::fixed << std::setprecision(2) << u.energy_q8/256.0 << ")";
-            u.dump_available_abilities(o);
+            o << "id=" << g.queen_id[i] << ",queen";
+            o << ",energy=(" << g.queen_energy_q8[i]
+                << "," << std::fixed << std::setprecision(2) << g.queen_energy_q8[i]/256.0 << ")";
+            o << ",";
+            if(g.queen_energy_q8[i]<spawn_creep_tumor_energy_cost_q8)
+                o << color_yellow << "needs_25_energy" << color_default;
+            else o << color_green << "available" << color_default;
             o << "\n";
         }
         o << "map=\n";
@@ -564,13 +752,15 @@ struct game
             o << y%10;
             for(uint x=0; x<g.map_dx; ++x)
             {
-                if(g.map_wall[y][x])
+                if(g.wall_at(pos(x,y)))
                     o << print_wall;
-                else if(g.map_building[y][x])
-                    o << (*g.map_building[y][x]).map_cell_code();
-                else if(g.map_creep[y][x])
+                else if(g.building_at(pos(x,y))==0)
+                    o << print_hatchery;
+                else if(g.building_on(pos(x,y)))
+                    o << g.tumor_cell_code(g.building_at(pos(x,y))-1);
+                else if(g.creep_at(pos(x,y)))
                     o << print_creep;
-                else if(0<g.map_creep_gen[y][x])
+                else if(g.creep_gen_at(pos(x,y)))
                 {
                     if(g.creep_spread_candidate(pos(x,y)))
                         o << print_creep_candidate;
@@ -587,73 +777,151 @@ struct game
         o << "creep_cover=" << g.creep_cover << std::endl;
         return o;
     }
-    bool hasValidMove() {
-        for (auto* unit : units) {
-            auto* q = static_cast<queen*>(unit);
-            if (q->energy_q8 >= 6400) {
+    bool hasValidMove() const {
+        if (tumor_count == max_creep_tumors) {
+            return false;
+        }
+        for (int i = 0; i < queen_count; ++i) {
+            if (queen_energy_q8[i] >= spawn_creep_tumor_energy_cost_q8) {
                 return true;
             }
         }
-        for (auto* building : buildings) {
-            if (building->name() == std::string("creep_tumor")) {
-                auto* ct = static_cast<creep_tumor*>(building);
-                if (ct->spawn_creep_tumor_active &&
-                    ct->dt_spawn_creep_tumor_cooldown_q8 <= 0)
-                {
-                    return true;
-                }
+        for (int i = 0; i < tumor_count; ++i) {
+            if (tumor_active[i] && tumor_cooldown_q8[i] <= 0) {
+                return true;
             }
         }
         return false;
     }
 
 
-    int next_id;
-    int t_q2;
-    int t_limit_q2;
-    pos p_base;
-    std::vector<building*> buildings;
-    std::vector<unit*> units;
-    int map_dx,map_dy;
-    std::array<std::array<int, map_max_dx>, map_max_dy> map_creep_gen;
-    std::array<std::array<bool, map_max_dx>, map_max_dy> map_creep;
-    int creep_cover;
-    std::array<std::array<bool, map_max_dx>, map_max_dy> map_wall;
-    building* map_building[map_max_dy][map_max_dx];
-
-    std::unique_ptr<game> clone() {
-        std::unique_ptr<game> other = std::make_unique<game>();
-        other->next_id = next_id;
-        other->t_q2 = t_q2;
-        other->t_limit_q2 = t_limit_q2;
-        other->p_base = p_base;
-        other->map_dx = map_dx;
-        other->map_dy = map_dy;
-        other->map_creep_gen = map_creep_gen;
-        other->map_creep = map_creep;
-        other->creep_cover = creep_cover;
-        other->map_wall = map_wall;
+    // Move generation for the rollouts, straight from the bitboards. Cells
+    // are listed in row major order, the same order the GUI Model uses.
 
-        for (building* b : buildings) {
-            other->buildings.push_back(b->clone());
+    // creep not covered by a building
+    row_bits creep_only_row(int y) const {
+        return map_creep[y] & ~map_blocked[y];
+    }
+    // creep may still spread here
+    row_bits free_row(int y) const {
+        return ~map_blocked[y] & ~map_creep[y] & row_mask();
+    }
+    // creep cells next to a free cell
+    row_bits edge_row(int y) const {
+        row_bits f = free_row(y);
+        row_bits n = f << 1 | f >> 1;
+        if (0 < y) {
+            n |= free_row(y-1);
         }
-
-        for (unit* u : units) {
-            other->units.push_back(u->clone());
+        if (y+1 < map_dy) {
+            n |= free_row(y+1);
         }
-
-        for (int x = 0; x < map_max_dx; ++x) {
-            for (int y = 0; y < map_max_dy; ++y) {
-                other->map_building[y][x] = map_building[y][x];
-                if (map_building[y][x]) {
-                    int index = std::find(begin(buildings), end(buildings), map_building[y][x]) - begin(buildings);
-                    other->map_building[y][x] = other->buildings[index];
-                }
+        return creep_only_row(y) & n;
+    }
+    // the available creep tumor at the lowest position, -1 if none
+    int available_tumor() const {
+        int best = -1;
+        for (int i = 0; i < tumor_count; ++i) {
+            if (tumor_active[i] && tumor_cooldown_q8[i] <= 0 &&
+                (best < 0 || tumor_pos[i] < tumor_pos[best]))
+            {
+                best = i;
+            }
+        }
+        return best;
+    }
+    // the first queen with enough energy to spawn, -1 if none
+    int available_queen() const {
+        for (int i = 0; i < queen_count; ++i) {
+            if (queen_energy_q8[i] >= spawn_creep_tumor_energy_cost_q8) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    void edge_cells(std::vector<pos> &cells) const {
+        for (int y = 0; y < map_dy; ++y) {
+            for (row_bits r = edge_row(y); r; r &= r-1) {
+                cells.push_back(pos(__builtin_ctzll(r), y));
+            }
+        }
+    }
+    // edge cells a creep tumor at p may spawn to
+    void edge_cells_around(std::vector<pos> &cells, pos const &p) const {
+        creep_disc const &disc = creep_disc::get();
+        for (int i = 0; i < creep_disc_size; ++i) {
+            int y = p.y-(creep_spread_radius-1)+i;
+            if (y < 0 || map_dy <= y) {
+                continue;
+            }
+            for (row_bits r = edge_row(y) & disc.at(i, p.x); r; r &= r-1) {
+                cells.push_back(pos(__builtin_ctzll(r), y));
+            }
+        }
+    }
+    // fallbacks when there are no edge cells, (-1,-1) if none
+    pos a_creep_cell() const {
+        row_bits mask = row_mask() & ~(bit_of(2)-1);
+        for (int y = 2; y < map_dy; ++y) {
+            if (row_bits r = creep_only_row(y) & mask) {
+                return pos(__builtin_ctzll(r), y);
+            }
+        }
+        return pos(-1, -1);
+    }
+    pos a_creep_cell_around(pos const &p) const {
+        creep_disc const &disc = creep_disc::get();
+        for (int i = 0; i < creep_disc_size; ++i) {
+            int y = p.y-(creep_spread_radius-1)+i;
+            if (y < 0 || map_dy <= y) {
+                continue;
+            }
+            if (row_bits r = creep_only_row(y) & disc.at(i, p.x) & row_mask()) {
+                return pos(__builtin_ctzll(r), y);
             }
         }
+        return pos(-1, -1);
+    }
+
+    // Zobrist hash of everything the future depends on but the ids. Creep
+    // spreads building by building in index order, so a tumor is keyed by
+    // its index as well as its cell: the same tumors made in another order
+    // spread differently. Queens only differ in their ids, so they are
+    // added up rather than XORed, since their energies may repeat.
+    std::uint64_t hash() const {
+        return hash(true);
+    }
+    // hash() without the tumor order. The same spawns made in another order
+    // only differ in which building spreads first, so a search may keep
+    // just one of them; rollout statistics must not be shared on it.
+    std::uint64_t layout_hash() const {
+        return hash(false);
+    }
+    std::uint64_t hash(bool ordered) const {
+        std::uint64_t h = map_hash ^ zobrist_key(zk_tick, t_q2);
+        for (int i = 0; i < tumor_count; ++i) {
+            int order = ordered ? i : 0;
+            h ^= zobrist_key(zk_tumor,
+                order*map_max_dx*map_max_dy
+                    +zobrist_cell(tumor_pos[i].x, tumor_pos[i].y),
+                tumor_active[i] ? tumor_cooldown_q8[i] : -1);
+        }
+        for (int i = 0; i < queen_count; ++i) {
+            h += zobrist_key(zk_queen, 0, queen_energy_q8[i]);
+        }
+        return h;
+    }
 
+    std::unique_ptr<game> clone() const {
+        std::unique_ptr<game> other = std::make_unique<game>();
+        std::memcpy(static_cast<game_state*>(other.get()),
+            static_cast<game_state const*>(this), sizeof(game_state));
         return other;
     }
 };
 
 void executeCommand(game& g, const Command& command);
+// Plays the commands at their ticks on a clone of start, then ticks while
+// anything_to_do(), the way creep.cc scores a command file.
+std::unique_ptr<game> playCommands(const game& start,
+    const std::vector<Command>& commands);
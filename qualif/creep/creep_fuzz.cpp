@@ -0,0 +1,461 @@
+#include "creep2.hh"
+#include "Command.hpp"
+#include "RandomMap.hpp"
+#include "Reference.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+// Differential test of creep2.hh against creep.cc, the organisers'
+// simulator: both play the same commands side by side and the state
+// snapshots are compared after every tick and every command, by hash, and
+// field by field once the hashes differ. Whether a command is valid must
+// agree too, and so must the state advance_until_next_decision jumps to
+// with the one ticked there.
+//
+// usage: creep_fuzz [-n cases] [-s seed] [-o dir]
+//        creep_fuzz map commands...
+//
+// Each case is a random map, written to the -o directory as
+// fuzz_<seed>.map, and a random command stream played on it: mostly valid
+// spawns of the available queens and tumors, with a few invalid ones
+// mixed in, which both simulators have to reject. A failing stream is
+// shrunk by dropping commands while it still fails, and written next to
+// its map as fuzz_<seed>_commands.in, the same format creep reads. The
+// maps of the passing cases are removed.
+//
+// Before the cases, a 64x64 map, fuzz_limit.map, is filled with tumors to
+// check the engine stops at max_creep_tumors with a spawn error.
+//
+// Given a map and command files, those are played instead, so
+// `creep_fuzz creep.map *_commands*.in` checks the committed games.
+
+namespace {
+
+struct FuzzStats {
+    long long ticks = 0;
+    int commands = 0; // executed
+    int rejected = 0;
+};
+
+// nullptr if the command is valid, the same reasons ReferenceGame gives
+const char* commandError(const game& g, const Command& command) {
+    pos p(command.x, command.y);
+    if (command.command == 1) {
+        int q = g.find_queen(command.id);
+        return q < 0 ? "invalid id" : g.queen_spawn_error(q, p);
+    }
+    if (command.command == 2) {
+        if (command.id == g.hatchery_id) {
+            return "not a creep tumor";
+        }
+        int i = g.find_creep_tumor(command.id);
+        return i < 0 ? "invalid id" : g.creep_tumor_spawn_error(i, p);
+    }
+    return "invalid cmd code";
+}
+
+GameSnapshot snapshot(const game& g) {
+    GameSnapshot s;
+    s.tick = g.t_q2;
+    s.timeLimit = g.t_limit_q2;
+    s.nextId = g.next_id;
+    s.cover = g.creep_cover;
+    s.creep.assign(g.map_creep, g.map_creep + g.map_dy);
+    s.creepGen.assign(g.map_creep_gen, g.map_creep_gen + g.map_dy);
+    for (int b = 0; b < g.building_count(); ++b) {
+        pos p = g.building_pos(b);
+        int active = b ? g.tumor_active[b - 1] : 0;
+        int cooldown = b ? g.tumor_cooldown_q8[b - 1] : 0;
+        s.buildings.push_back({g.building_id(b), p.x, p.y,
+            g.building_size(b), active, cooldown});
+    }
+    for (int i = 0; i < g.queen_count; ++i) {
+        s.queens.push_back({g.queen_id[i], g.queen_energy_q8[i]});
+    }
+    return s;
+}
+
+// Plays the commands on both simulators the way creep.cc's main does,
+// skipping the ones both reject. Returns where they first disagree, empty
+// if they never do.
+std::string replay(const std::string& map, const std::vector<Command>& commands,
+    FuzzStats* stats = nullptr)
+{
+    auto g = std::make_unique<game>(map.c_str());
+    ReferenceGame ref(map);
+    std::ostringstream os;
+    auto compare = [&](const char* after) {
+        auto mine = snapshot(*g);
+        auto theirs = ref.snapshot();
+        if (mine.hash() != theirs.hash()) {
+            os << "t=" << g->t_q2 << " after " << after << ": "
+                << firstDifference(mine, theirs);
+            return false;
+        }
+        return true;
+    };
+
+    // a clone jumped to the next decision with advance_until_next_decision,
+    // checked when the ticks get there
+    std::unique_ptr<game> skipped;
+    auto tick = [&](int tStop) {
+        if (!skipped && !g->hasValidMove()) {
+            skipped = g->clone();
+            skipped->advance_until_next_decision(tStop);
+            if (skipped->t_q2 == g->t_q2) {
+                skipped.reset();
+            }
+        }
+        g->tick();
+        ref.tick();
+        if (stats) {
+            ++stats->ticks;
+        }
+        if (!compare("tick")) {
+            return false;
+        }
+        if (skipped && skipped->t_q2 == g->t_q2) {
+            auto diff = firstDifference(snapshot(*skipped), snapshot(*g));
+            if (!diff.empty()) {
+                os << "t=" << g->t_q2 << " after advance_until_next_decision: "
+                    << diff;
+                return false;
+            }
+            skipped.reset();
+        }
+        return true;
+    };
+
+    if (!compare("loading the map")) {
+        return os.str();
+    }
+    for (std::size_t n = 0; n < commands.size() && g->t_q2 < g->t_limit_q2; ++n) {
+        auto& c = commands[n];
+        while (g->t_q2 < c.t && g->t_q2 < g->t_limit_q2) {
+            if (!tick(std::min(c.t, g->t_limit_q2))) {
+                return os.str();
+            }
+        }
+        // a jump that stopped short where the map got covered never matches
+        skipped.reset();
+        if (g->t_q2 >= g->t_limit_q2) {
+            break;
+        }
+        const char* mine = commandError(*g, c);
+        const char* theirs = ref.commandError(c.command, c.id, c.x, c.y);
+        if (!mine != !theirs || (mine && strcmp(mine, theirs) != 0)) {
+            os << "t=" << g->t_q2 << " command " << n << " (" << c.command
+                << " " << c.id << " " << c.x << " " << c.y << "): "
+                << (mine ? mine : "valid") << " vs "
+                << (theirs ? theirs : "valid");
+            return os.str();
+        }
+        if (mine) {
+            if (stats) {
+                ++stats->rejected;
+            }
+            continue;
+        }
+        executeCommand(*g, c);
+        ref.execute(c.command, c.id, c.x, c.y);
+        if (stats) {
+            ++stats->commands;
+        }
+        if (!compare("a command")) {
+            return os.str();
+        }
+    }
+    while (true) {
+        bool mine = g->anything_to_do();
+        if (mine != ref.anythingToDo()) {
+            os << "t=" << g->t_q2 << " anything_to_do: " << mine << " vs "
+                << !mine;
+            return os.str();
+        }
+        if (!mine || g->t_q2 >= g->t_limit_q2) {
+            break;
+        }
+        if (!tick(g->t_limit_q2)) {
+            return os.str();
+        }
+    }
+    return {};
+}
+
+// a random position near center, sometimes anywhere on the map
+pos randomTarget(const game& g, pos center, int radius, std::mt19937& rng) {
+    if (rng() % 16 == 0) {
+        return pos(rng() % g.map_dx, rng() % g.map_dy);
+    }
+    return pos(center.x + int(rng() % (2 * radius + 1)) - radius,
+        center.y + int(rng() % (2 * radius + 1)) - radius);
+}
+
+// Plays random spawns on the map: every tick each available queen and
+// tumor spawns with a small chance, at a target found by rejection
+// sampling. A few commands are left invalid on purpose: a random target,
+// an actor that isn't ready or the wrong kind of id.
+std::vector<Command> randomCommands(const std::string& map, std::mt19937& rng) {
+    auto g = std::make_unique<game>(map.c_str());
+    std::vector<Command> commands;
+    auto issue = [&](int cmd, int id, pos center, int radius, bool valid) {
+        Command c;
+        c.t = g->t_q2;
+        c.command = cmd;
+        c.id = id;
+        for (int tries = 0; tries < 32; ++tries) {
+            pos p = randomTarget(*g, center, radius, rng);
+            c.x = p.x;
+            c.y = p.y;
+            if (!valid || !commandError(*g, c)) {
+                break;
+            }
+        }
+        commands.push_back(c);
+        if (!commandError(*g, c)) {
+            executeCommand(*g, c);
+        }
+    };
+
+    pos middle(g->map_dx / 2, g->map_dy / 2);
+    int anywhere = std::max(g->map_dx, g->map_dy) / 2;
+    while (g->t_q2 < g->t_limit_q2 && g->has_empty()) {
+        for (int i = 0; i < g->queen_count; ++i) {
+            if (g->queen_energy_q8[i] >= spawn_creep_tumor_energy_cost_q8 &&
+                g->tumor_count < max_creep_tumors - 1 && rng() % 8 == 0)
+            {
+                issue(1, g->queen_id[i], middle, anywhere, true);
+            }
+        }
+        for (int i = 0; i < g->tumor_count; ++i) {
+            if (g->tumor_active[i] && g->tumor_cooldown_q8[i] == 0 &&
+                g->tumor_count < max_creep_tumors - 1 && rng() % 8 == 0)
+            {
+                issue(2, g->tumor_id[i], g->tumor_pos[i],
+                    spawn_creep_tumor_radius, true);
+            }
+        }
+        if (rng() % 64 == 0) {
+            int id = rng() % (g->next_id + 2);
+            issue(1 + rng() % 2, id, middle, anywhere, false);
+        }
+        g->tick();
+    }
+    return commands;
+}
+
+// drops runs of commands, halving the run length, while the rest still
+// fails
+std::vector<Command> shrink(const std::string& map, std::vector<Command> commands) {
+    for (std::size_t chunk = std::max<std::size_t>(1, commands.size() / 2);
+        chunk > 0; chunk /= 2)
+    {
+        for (std::size_t start = 0; start < commands.size();) {
+            auto fewer = commands;
+            fewer.erase(fewer.begin() + start,
+                fewer.begin() + std::min(commands.size(), start + chunk));
+            if (!replay(map, fewer).empty()) {
+                commands = std::move(fewer);
+            } else {
+                start += chunk;
+            }
+        }
+    }
+    return commands;
+}
+
+void writeCommands(const std::string& file, const std::vector<Command>& commands) {
+    std::ofstream out(file);
+    out << commands.size() << std::endl;
+    for (auto& command : commands) {
+        out << command.t << " " << command.command << " " << command.id
+            << " " << command.x << " " << command.y << "\n";
+    }
+}
+
+// the commands of a file, without the ticks LoadCommands pads them with
+std::vector<Command> readCommands(const std::string& file) {
+    auto commands = LoadCommands(file);
+    commands.erase(std::remove_if(commands.begin(), commands.end(),
+        [](const Command& c) { return c.command <= 0; }), commands.end());
+    return commands;
+}
+
+struct CaseResult {
+    std::string failure;
+    int commands = 0; // generated
+    int shrunk = 0;
+    FuzzStats stats;
+};
+
+CaseResult fuzzCase(const std::string& dir, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    int width = 16 + rng() % 49;
+    int height = 16 + rng() % 49;
+    int timeLimit = 200 + rng() % 1800;
+    std::string map = dir + "/fuzz_" + std::to_string(seed) + ".map";
+    {
+        std::ofstream out(map);
+        writeRandomMap(out, seed, width, height, timeLimit);
+    }
+
+    CaseResult result;
+    auto commands = randomCommands(map, rng);
+    result.commands = commands.size();
+    result.failure = replay(map, commands, &result.stats);
+    if (result.failure.empty()) {
+        std::remove(map.c_str());
+        return result;
+    }
+    commands = shrink(map, commands);
+    result.shrunk = commands.size();
+    result.failure = replay(map, commands);
+    writeCommands(dir + "/fuzz_" + std::to_string(seed) + "_commands.in",
+        commands);
+    return result;
+}
+
+// Past max_creep_tumors, which creep.cc doesn't have, the engine must
+// refuse spawns rather than overflow its arrays: fills a map with queen
+// spawns, refilling the energy, up to the limit and checks the next one is
+// a spawn error that changes nothing. Empty if it holds.
+std::string checkTumorLimit(const std::string& map) {
+    auto g = std::make_unique<game>(map.c_str());
+    auto freeCreep = [&](pos& p) {
+        for (p.y = 0; p.y < g->map_dy; ++p.y) {
+            for (p.x = 0; p.x < g->map_dx; ++p.x) {
+                if (!g->wall_at(p) && !g->building_on(p) &&
+                    g->creep_at(p))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    pos p;
+    while (g->tumor_count < max_creep_tumors) {
+        g->queen_energy_q8[0] = spawn_creep_tumor_energy_cost_q8;
+        if (freeCreep(p)) {
+            g->queen_spawn_creep_tumor(0, p);
+        } else if (g->anything_to_do()) {
+            g->tick();
+        } else {
+            return "the map has no room for max_creep_tumors";
+        }
+    }
+    g->queen_energy_q8[0] = spawn_creep_tumor_energy_cost_q8;
+    int ticks = 0;
+    while (!freeCreep(p)) {
+        if (!g->anything_to_do() || ticks++ == 1000) {
+            return "no creep left to spawn on past the limit";
+        }
+        g->tick();
+    }
+    const char* error = g->queen_spawn_error(0, p);
+    if (!error || strcmp(error, "too many creep tumors") != 0) {
+        return std::string("queen spawn past the limit: ") +
+            (error ? error : "valid");
+    }
+    g->tumor_cooldown_q8[0] = 0;
+    pos near = g->tumor_pos[0];
+    error = g->creep_tumor_spawn_error(0, near);
+    if (!error || strcmp(error, "too many creep tumors") != 0) {
+        return std::string("tumor spawn past the limit: ") +
+            (error ? error : "valid");
+    }
+    if (g->hasValidMove()) {
+        return "hasValidMove past the limit";
+    }
+    auto before = snapshot(*g);
+    g->queen_spawn_creep_tumor(0, p);
+    auto diff = firstDifference(before, snapshot(*g));
+    if (!diff.empty()) {
+        return "queen spawn past the limit changed " + diff;
+    }
+    return {};
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    int cases = 100;
+    std::uint32_t seed = 1;
+    std::string dir = ".";
+    std::vector<std::string> files;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            cases = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-o" && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (arg[0] == '-') {
+            usage = true;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (usage || files.size() == 1) {
+        std::cerr << "usage: " << argv[0] << " [-n cases] [-s seed] [-o dir]\n"
+            "       " << argv[0] << " map commands..." << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int failed = 0;
+    FuzzStats total;
+    if (!files.empty()) {
+        for (std::size_t i = 1; i < files.size(); ++i) {
+            FuzzStats stats;
+            auto failure = replay(files[0], readCommands(files[i]), &stats);
+            std::cout << files[i] << " " << (failure.empty() ? "same" : failure)
+                << std::endl;
+            failed += !failure.empty();
+            total.ticks += stats.ticks;
+            total.commands += stats.commands;
+        }
+    } else {
+        std::string limitMap = dir + "/fuzz_limit.map";
+        {
+            std::ofstream out(limitMap);
+            writeRandomMap(out, seed, 64, 64);
+        }
+        auto failure = checkTumorLimit(limitMap);
+        if (failure.empty()) {
+            std::remove(limitMap.c_str());
+        } else {
+            std::cout << limitMap << ": " << failure << std::endl;
+            ++failed;
+        }
+        std::vector<CaseResult> results(cases);
+        ThreadPool::instance().run(cases, [&](int, int i) {
+            results[i] = fuzzCase(dir, seed + i);
+        });
+        for (int i = 0; i < cases; ++i) {
+            auto& r = results[i];
+            total.ticks += r.stats.ticks;
+            total.commands += r.stats.commands;
+            total.rejected += r.stats.rejected;
+            if (!r.failure.empty()) {
+                std::cout << "seed " << seed + i << ": " << r.failure
+                    << " (" << r.commands << " commands, shrunk to "
+                    << r.shrunk << ")" << std::endl;
+                ++failed;
+            }
+        }
+        std::cout << cases << " cases, " << failed << " failed" << std::endl;
+    }
+    std::cerr << total.ticks << " ticks, " << total.commands
+        << " commands and " << total.rejected << " rejected ones compared in "
+        << std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count()
+        << " s" << std::endl;
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,53 @@
+#include "creep2.hh"
+#include "BeamSearch.hpp"
+
+#include <chrono>
+
+// Plans a whole game without a display by beam search, see BeamSearch.hpp,
+// and writes the commands in the LoadCommands format.
+//
+// usage: creep_plan [-w width] [-o output] map
+
+int main(int argc, char** argv) {
+    int width = 16;
+    std::string output;
+    std::string map;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-w" && i + 1 < argc) {
+            width = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            map = arg;
+        }
+    }
+    if (map.empty()) {
+        std::cerr << "usage: " << argv[0] << " [-w width] [-o output] map"
+            << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    BeamResult result = beamSearch(game(map.c_str()), width);
+    auto& plan = result.commands;
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+    out << plan.size() << std::endl;
+    for (auto& command : plan) {
+        out << command.t << " " << command.command << " " << command.id
+            << " " << command.x << " " << command.y << "\n";
+    }
+
+    std::cerr << "covered " << result.cover << " cells by t="
+        << result.tick << " with " << plan.size() << " commands, "
+        << result.expanded << " states expanded in "
+        << std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count()
+        << " s" << std::endl;
+    return 0;
+}
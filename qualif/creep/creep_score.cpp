@@ -0,0 +1,156 @@
+#include "creep2.hh"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <sstream>
+
+// Scores command files without a display: every file is replayed on the
+// map the way creep.cc does it, on the thread pool, and only the final tick
+// and whether the commands were valid are printed.
+//
+// usage: creep_score [-r repeats] [-c] map commands...
+//
+// One line per file on stdout:
+//     <file> ok <final tick> <creep cover>
+//     <file> invalid <final tick> <creep cover> command <n>: <reason>
+//
+// -c checks the simulation against the committed files: those are named
+// after the final tick they reached (641_commands.in), and a file scoring
+// anything else is reported as
+//     <file> mismatch <final tick> <creep cover> expected <tick>
+// The throughput is written to stderr.
+
+namespace {
+
+struct ScoreResult {
+    bool valid = true;
+    std::string error;
+    int tick = 0;
+    int cover = 0;
+};
+
+ScoreResult scoreFile(const game& base, const std::string& file) {
+    ScoreResult result;
+    auto g = base.clone();
+    auto fail = [&](int n, const std::string& reason) {
+        std::ostringstream os;
+        os << "command " << n << ": " << reason;
+        result.valid = false;
+        result.error = os.str();
+    };
+
+    std::ifstream in(file);
+    int count = 0;
+    if (!(in >> count)) {
+        fail(0, "can't read the command count");
+    }
+    for (int n = 0; result.valid && n < count && g->t_q2 < g->t_limit_q2; ++n) {
+        int t, cmd, id, x, y;
+        if (!(in >> t >> cmd >> id >> x >> y)) {
+            fail(n, "can't read the command");
+            break;
+        }
+        if (t < g->t_q2) {
+            fail(n, "can't go back in time sry");
+            break;
+        }
+        while (g->t_q2 < t && g->t_q2 < g->t_limit_q2) {
+            g->tick();
+        }
+        const char* error = nullptr;
+        if (cmd == 1) {
+            int q = g->find_queen(id);
+            error = q < 0 ? "invalid id" : g->queen_spawn_error(q, pos(x, y));
+            if (!error) {
+                g->queen_spawn_creep_tumor(q, pos(x, y));
+            }
+        } else if (cmd == 2) {
+            int i = g->find_creep_tumor(id);
+            error = i < 0 ? "invalid id" : g->creep_tumor_spawn_error(i, pos(x, y));
+            if (!error) {
+                g->creep_tumor_spawn_creep_tumor(i, pos(x, y));
+            }
+        } else {
+            error = "invalid cmd code";
+        }
+        if (error) {
+            fail(n, error);
+        }
+    }
+    while (result.valid && g->anything_to_do() && g->t_q2 < g->t_limit_q2) {
+        g->tick();
+    }
+    result.tick = g->t_q2;
+    result.cover = g->creep_cover;
+    return result;
+}
+
+// the leading number of the file name, -1 if there is none
+int expectedTick(const std::string& file) {
+    auto slash = file.find_last_of('/');
+    std::string name = slash == std::string::npos ? file : file.substr(slash + 1);
+    if (name.empty() || !isdigit(name[0])) {
+        return -1;
+    }
+    return atoi(name.c_str());
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    int repeats = 1;
+    bool check = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "-r" && i + 1 < argc) {
+            repeats = std::max(1, atoi(argv[++i]));
+        } else if (std::string(argv[i]) == "-c") {
+            check = true;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (args.size() < 2) {
+        std::cerr << "usage: " << argv[0] << " [-r repeats] [-c] map commands..."
+            << std::endl;
+        return 1;
+    }
+
+    game base(args[0].c_str());
+    std::vector<std::string> files(args.begin() + 1, args.end());
+    std::vector<ScoreResult> results(files.size());
+
+    auto& pool = ThreadPool::instance();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        pool.run(files.size(), [&](int, int i) {
+            results[i] = scoreFile(base, files[i]);
+        });
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    int invalid = 0;
+    int mismatched = 0;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        auto& result = results[i];
+        int expected = check ? expectedTick(files[i]) : -1;
+        bool mismatch = result.valid && expected >= 0 && expected != result.tick;
+        std::cout << files[i] << " "
+            << (!result.valid ? "invalid" : mismatch ? "mismatch" : "ok")
+            << " " << result.tick << " " << result.cover;
+        if (!result.valid) {
+            std::cout << " " << result.error;
+            ++invalid;
+        } else if (mismatch) {
+            std::cout << " expected " << expected;
+            ++mismatched;
+        }
+        std::cout << std::endl;
+    }
+    int scored = files.size() * repeats;
+    std::cerr << "scored " << scored << " files in " << ms << " ms on "
+        << pool.size() << " threads, " << scored * 1000.0 / ms
+        << " files/s" << std::endl;
+    return invalid ? 2 : mismatched ? 3 : 0;
+}
@@ -0,0 +1,187 @@
+#include "creep2.hh"
+#include "BeamSearch.hpp"
+#include "MC.hpp"
+#include "RandomMap.hpp"
+#include "Rollout.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Plays a planner on many maps without a display and prints a table of the
+// final ticks and wall clock times, to compare AI changes across maps.
+//
+// usage: creep_tournament [-p greedy|mc|beam] [-w width] [-n random maps]
+//     [-s seed] [-o map dir] [maps or directories of *.map...]
+//
+// The -n random maps are written to the -o directory, the current one by
+// default, as random_<seed>.map, and played with the others. greedy is
+// GetCommand; its games run in parallel on the thread pool. mc and beam
+// already use the pool for every decision, so their maps are played one
+// after the other. greedy draws from a stream of the master seed keyed by
+// the map, so CREEP_SEED reproduces its games too.
+//
+// A game ends the way creep.cc ends it: the tick and cover are what creep
+// scores the commands played with.
+
+namespace {
+
+struct GameResult {
+    int tick = 0;
+    int cover = 0;
+    int cells = 0; // not walls
+    int commands = 0;
+    double seconds = 0;
+};
+
+using Planner = std::function<Command(const game&)>;
+
+// plays the planner whenever there is a valid move, and ticks when it
+// passes, until nothing can change any more
+void playGame(const game& start, const Planner& planner, GameResult& result) {
+    auto g = start.clone();
+    std::vector<Command> commands;
+    while (!g->creep_finished() && g->t_q2 < g->t_limit_q2) {
+        if (!g->hasValidMove()) {
+            g->advance_until_next_decision(g->t_limit_q2);
+            continue;
+        }
+        Command command = planner(*g);
+        if (command.command > 0) {
+            command.t = g->t_q2;
+            commands.push_back(command);
+        }
+        executeCommand(*g, command);
+    }
+    auto scored = playCommands(start, commands);
+    result.tick = scored->t_q2;
+    result.cover = scored->creep_cover;
+    result.commands = commands.size();
+}
+
+GameResult playMap(const std::string& map, const std::string& planner,
+    int width)
+{
+    auto start = std::chrono::steady_clock::now();
+    GameResult result;
+    auto g = std::make_unique<game>(map.c_str());
+    for (int y = 0; y < g->map_dy; ++y) {
+        result.cells += bit_count(~g->map_wall[y] & g->row_mask());
+    }
+    if (planner == "beam") {
+        BeamResult beam = beamSearch(*g, width);
+        result.tick = beam.tick;
+        result.cover = beam.cover;
+        result.commands = beam.commands.size();
+    } else if (planner == "mc") {
+        playGame(*g, [](const game& g) {
+            return MonteCarlo(&g).getAutoMove();
+        }, result);
+    } else {
+        auto rng = rolloutRNG(g->hash(), 0);
+        playGame(*g, [&](const game& g) {
+            return GetCommand(g, rng);
+        }, result);
+    }
+    result.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+bool isDirectory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+void addMaps(const std::string& path, std::vector<std::string>& maps) {
+    if (!isDirectory(path)) {
+        maps.push_back(path);
+        return;
+    }
+    std::vector<std::string> found;
+    if (DIR* dir = opendir(path.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.substr(name.size() - 4) == ".map") {
+                found.push_back(path + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(found.begin(), found.end());
+    maps.insert(maps.end(), found.begin(), found.end());
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    std::string planner = "greedy";
+    int width = 16;
+    int randomMaps = 0;
+    std::uint32_t seed = 1;
+    std::string mapDir = ".";
+    std::vector<std::string> maps;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            planner = argv[++i];
+        } else if (arg == "-w" && i + 1 < argc) {
+            width = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-n" && i + 1 < argc) {
+            randomMaps = std::max(0, atoi(argv[++i]));
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-o" && i + 1 < argc) {
+            mapDir = argv[++i];
+        } else {
+            addMaps(arg, maps);
+        }
+    }
+    if ((planner != "greedy" && planner != "mc" && planner != "beam") ||
+        (maps.empty() && randomMaps == 0))
+    {
+        std::cerr << "usage: " << argv[0] << " [-p greedy|mc|beam] [-w width]"
+            " [-n random maps] [-s seed] [-o map dir]"
+            " [maps or directories of *.map...]" << std::endl;
+        return 1;
+    }
+
+    for (int i = 0; i < randomMaps; ++i) {
+        std::string file = mapDir + "/random_" + std::to_string(seed + i) + ".map";
+        std::ofstream out(file);
+        writeRandomMap(out, seed + i);
+        maps.push_back(file);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<GameResult> results(maps.size());
+    if (planner == "greedy") {
+        ThreadPool::instance().run(maps.size(), [&](int, int i) {
+            results[i] = playMap(maps[i], planner, width);
+        });
+    } else {
+        for (std::size_t i = 0; i < maps.size(); ++i) {
+            results[i] = playMap(maps[i], planner, width);
+        }
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    printf("%-32s %-6s %6s %11s %8s %10s\n",
+        "map", "plan", "tick", "cover", "commands", "ms");
+    long long ticks = 0;
+    int covered = 0;
+    for (std::size_t i = 0; i < maps.size(); ++i) {
+        auto& r = results[i];
+        printf("%-32s %-6s %6d %5d/%-5d %8d %10.1f\n", maps[i].c_str(),
+            planner.c_str(), r.tick, r.cover, r.cells, r.commands,
+            r.seconds * 1000);
+        ticks += r.tick;
+        covered += r.cover == r.cells;
+    }
+    printf("%zu maps, %d covered, mean tick %.1f, %.2f s, %.2f maps/s\n",
+        maps.size(), covered, double(ticks) / maps.size(), seconds,
+        maps.size() / seconds);
+    return 0;
+}
@@ -1,15 +1,16 @@
 #include "Game.hpp"
 #include <boost/algorithm/string/join.hpp>
 #include <iostream>
+#include <sstream>
 #include <chrono>
 #include <thread>
 #include <algorithm>
 
 namespace gui {
 
-Game::Game(const Model& model)
+Game::Game(Model model)
     : window(sf::VideoMode(1600, 1600), "Title")
-    , model(model)
+    , model(std::move(model))
 {}
 
 void Game::run() {
@@ -31,8 +32,8 @@ void Game::run() {
     }
 }
 
-void Game::setModel(const Model& model) {
-    this->model = model;
+void Game::setModel(Model model) {
+    this->model = std::move(model);
 }
 
 void Game::setCommandCallback(const CommandCallback& callback) {
@@ -86,8 +87,8 @@ void Game::handleMouseButtonPressedEvent(const sf::Event::MouseButtonEvent& ev)
 }
 
 sf::Vector2i Game::windowToTile(int wx, int wy) const {
-    auto columns = model.tiles.shape()[0];
-    auto rows = model.tiles.shape()[1];
+    auto columns = model.columns;
+    auto rows = model.rows;
 
     float width = window.getSize().x;
     float height = window.getSize().y;
@@ -168,19 +169,7 @@ void Game::handleMouseMovedEvent(const sf::Event::MouseMoveEvent& ev) {
 }
 
 void Game::selectNextTumor(bool forward) {
-    auto xmax = model.tiles.shape()[0];
-    auto ymax = model.tiles.shape()[1];
-    std::vector<sf::Vector2i> tumors;
-
-    for (int y = 0; y < ymax; ++y) {
-        for (int x = 0; x < xmax; ++x) {
-            auto* tumor = boost::get<CreepTumor>(&model.tiles[x][y]);
-            if (!tumor || tumor->state != CreepTumor::State::Active) {
-                continue;
-            }
-            tumors.push_back({x, y});
-        }
-    }
+    auto& tumors = model.activeTumors;
 
     if (tumors.empty()) {
         return;
@@ -199,11 +188,11 @@ void Game::selectNextTumor(bool forward) {
 }
 
 void Game::clickOn(const sf::Vector2i& p) {
-    auto columns = model.tiles.shape()[0];
-    auto rows = model.tiles.shape()[1];
+    auto columns = model.columns;
+    auto rows = model.rows;
 
-    auto* creepTumor = boost::get<CreepTumor>(&model.tiles[p.x][p.y]);
-    auto* creep = boost::get<Creep>(&model.tiles[p.x][p.y]);
+    auto* creepTumor = model.tumorAt(p);
+    bool creep = model.tileAt(p) == Tile::Creep;
     if (creepTumor) {
         if (creepTumor->state == CreepTumor::State::Active) {
             inputMode = InputMode::TumorSpawn;
@@ -220,7 +209,7 @@ void Game::clickOn(const sf::Vector2i& p) {
             }
 
             sendCommand(Command::TumorSpawn(
-                boost::get<CreepTumor>(&model.tiles[activeTumorPos.x][activeTumorPos.y])->id,
+                model.tumorAt(activeTumorPos)->id,
                 p.x, p.y));
             activeTumorPos = {-1, -1};
         } else if (inputMode == InputMode::QueenSpawn) {
@@ -287,64 +276,51 @@ sf::Color cooldownColor(int ticks) {
     return sf::Color(255, 255 - ticks * 4, 0);
 }
 
-struct Game::TileDrawer : boost::static_visitor<> {
-    TileDrawer(
-        Game& game,
-        const sf::Vector2i& position) :
-        game(game),
-        position(position)
-    {}
-
-    void operator()(const Hatchery&) {
-        game.drawTile(position, sf::Color{192, 0, 192});
-        game.drawSmallTile(position, sf::Color{144, 0, 255});
-    }
-
-    void operator()(const Wall&) {
-        game.drawTile(position, sf::Color{169, 169, 169});
-    }
-
-    void operator()(const Empty&) {
-        game.drawTile(position, sf::Color::Black);
-    }
-
-    void operator()(const Creep&) {
-        game.drawTile(position, sf::Color{192, 0, 192});
-    }
-
-    void operator()(const CreepTumor& ct) {
-        game.drawTile(position, sf::Color{192, 0, 192});
-        switch (ct.state) {
-            case CreepTumor::State::Active:
-                game.drawSmallTile(position, sf::Color::Green);
-                break;
-            case CreepTumor::State::Cooldown:
-                game.drawSmallTile(position, cooldownColor(ct.cooldown));
-                break;
-            case CreepTumor::State::InActive:
-                game.drawSmallTile(position, sf::Color{144, 0, 255});
-                break;
+void Game::drawCell(const sf::Vector2i& p) {
+    switch (model.tileAt(p)) {
+        case Tile::Hatchery:
+            drawTile(p, sf::Color{192, 0, 192});
+            drawSmallTile(p, sf::Color{144, 0, 255});
+            break;
+        case Tile::Wall:
+            drawTile(p, sf::Color{169, 169, 169});
+            break;
+        case Tile::Empty:
+            drawTile(p, sf::Color::Black);
+            break;
+        case Tile::Creep:
+            drawTile(p, sf::Color{192, 0, 192});
+            break;
+        case Tile::CreepTumor: {
+            auto& ct = *model.tumorAt(p);
+            drawTile(p, sf::Color{192, 0, 192});
+            switch (ct.state) {
+                case CreepTumor::State::Active:
+                    drawSmallTile(p, sf::Color::Green);
+                    break;
+                case CreepTumor::State::Cooldown:
+                    drawSmallTile(p, cooldownColor(ct.cooldown));
+                    break;
+                case CreepTumor::State::InActive:
+                    drawSmallTile(p, sf::Color{144, 0, 255});
+                    break;
+            }
+            break;
         }
+        case Tile::CreepCandidate:
+            drawTile(p, sf::Color::Black);
+            drawSmallTile(p, sf::Color{192, 0, 192});
+            break;
+        case Tile::CreepRadius:
+            drawTile(p, sf::Color::Black);
+            drawSmallTile(p, sf::Color{128, 0, 128});
+            break;
     }
-
-    void operator()(const CreepCandidate&) {
-        game.drawTile(position, sf::Color::Black);
-        game.drawSmallTile(position, sf::Color{192, 0, 192});
-    }
-
-    void operator()(const CreepRadius&) {
-        game.drawTile(position, sf::Color::Black);
-        game.drawSmallTile(position, sf::Color{128, 0, 128});
-    }
-
-private:
-    Game& game;
-    sf::Vector2i position;
-};
+}
 
 void Game::drawTile(const sf::Vector2i& p, const sf::Color& color) {
-    auto columns = model.tiles.shape()[0];
-    auto rows = model.tiles.shape()[1];
+    auto columns = model.columns;
+    auto rows = model.rows;
 
     float width = window.getSize().x;
     float height = window.getSize().y;
@@ -359,8 +335,8 @@ void Game::drawTile(const sf::Vector2i& p, const sf::Color& color) {
 }
 
 void Game::drawSmallTile(const sf::Vector2i& p, const sf::Color& color) {
-    auto columns = model.tiles.shape()[0];
-    auto rows = model.tiles.shape()[1];
+    auto columns = model.columns;
+    auto rows = model.rows;
 
     float width = window.getSize().x;
     float height = window.getSize().y;
@@ -379,16 +355,15 @@ void Game::drawSmallTile(const sf::Vector2i& p, const sf::Color& color) {
 void Game::draw() {
     window.clear();
 
-    auto columns = model.tiles.shape()[0];
-    auto rows = model.tiles.shape()[1];
+    auto columns = model.columns;
+    auto rows = model.rows;
 
     float width = window.getSize().x;
     float height = window.getSize().y;
 
     for (auto y = 0; y < rows; ++y) {
         for (auto x = 0; x < columns; ++x) {
-            TileDrawer tileDrawer{*this, {x, y}};
-            boost::apply_visitor(tileDrawer, model.tiles[x][y]);
+            drawCell({x, y});
         }
     }
     for (auto& p : beacons) {
@@ -2,6 +2,7 @@
 
 #include "../Model.hpp"
 #include <SFML/Graphics.hpp>
+#include <functional>
 
 namespace gui {
 
@@ -12,10 +13,10 @@ public:
     using RedoCallback = std::function<void()>;
     using AutoCallback = std::function<void()>;
 
-    Game(const Model& model);
+    Game(Model model);
 
     void run();
-    void setModel(const Model& model);
+    void setModel(Model model);
     void setCommandCallback(const CommandCallback& callback);
     void setUndoCallback(const UndoCallback& callback);
     void setRedoCallback(const RedoCallback& callback);
@@ -32,6 +33,7 @@ private:
 
     void drawTile(const sf::Vector2i& p, const sf::Color& color);
     void drawSmallTile(const sf::Vector2i& p, const sf::Color& color);
+    void drawCell(const sf::Vector2i& p);
     void draw();
 
     sf::Vector2i windowToTile(int wx, int wy) const;
@@ -64,8 +66,6 @@ private:
     AutoCallback autoCallback;
 
     sf::RenderWindow window;
-
-    struct TileDrawer;
 };
 
 } // namespace gui